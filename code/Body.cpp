@@ -59,6 +59,27 @@ Vec3 Body::LocalToWorld( const Vec3& local_pos ) const
 	return GetWorldMassCenter() + orientation.RotatePoint(local_pos);
 }
 
+Vec3 Body::GetWorldMassCenterAt( float dt ) const
+{
+	return GetWorldMassCenter() + linearVelocity * dt;
+}
+
+Quat Body::GetOrientationAt( float dt ) const
+{
+	Vec3 delta_angle = angularVelocity * dt;
+	Quat delta_orientation = Quat( delta_angle, delta_angle.GetMagnitude() );
+
+	Quat new_orientation = delta_orientation * orientation;
+	new_orientation.Normalize();
+	return new_orientation;
+}
+
+Vec3 Body::WorldToLocalAt( const Vec3& world_pos, float dt ) const
+{
+	const Quat invert_orientation = GetOrientationAt( dt ).Inverse();
+	return invert_orientation.RotatePoint( world_pos - GetWorldMassCenterAt( dt ) );
+}
+
 void Body::ApplyImpulse( const Vec3& origin, const Vec3& impulse )
 {
 	if ( IsStatic() ) return;
@@ -85,7 +106,20 @@ void Body::ApplyAngularImpulse( const Vec3& impulse )
 	if ( IsStatic() ) return;
 
 	angularVelocity += GetWorldInverseInertiaTensor() * impulse;
+	ClampAngularVelocity();
+}
 
+void Body::ApplyVelocityChange( const Vec3& linear_change, const Vec3& angular_change )
+{
+	if ( IsStatic() ) return;
+
+	linearVelocity += linear_change;
+	angularVelocity += angular_change;
+	ClampAngularVelocity();
+}
+
+void Body::ClampAngularVelocity()
+{
 	//  clamp angular velocity speed
 	const float max_angular_speed = 30.0f;
 	if ( angularVelocity.GetLengthSqr() > max_angular_speed * max_angular_speed )
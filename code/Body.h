@@ -26,9 +26,17 @@ public:
 	Vec3 WorldToLocal( const Vec3& world_pos ) const;
 	Vec3 LocalToWorld( const Vec3& local_pos ) const;
 
+	//  extrapolated state after dt without touching the body, the gyroscopic
+	//  term of Update is left out (null for spheres, second order otherwise)
+	Vec3 GetWorldMassCenterAt( float dt ) const;
+	Quat GetOrientationAt( float dt ) const;
+	Vec3 WorldToLocalAt( const Vec3& world_pos, float dt ) const;
+
 	void ApplyImpulse( const Vec3& origin, const Vec3& impulse );
 	void ApplyLinearImpulse( const Vec3& impulse );
 	void ApplyAngularImpulse( const Vec3& impulse );
+	//  add velocities already scaled by the inverse mass & inertia
+	void ApplyVelocityChange( const Vec3& linear_change, const Vec3& angular_change );
 
 	void SetMass( float mass );
 	float GetMass() const { return mass; }
@@ -42,6 +50,8 @@ public:
 	}
 
 private:
+	void ClampAngularVelocity();
+
 	float mass;
 	float inverseMass;
 };
@@ -1,12 +1,11 @@
 #include "Contact.h"
+#include "Manifold.h"
 
-void Contact::Resolve()
+float Contact::ComputeNormalMass( Vec3& velocity_ab ) const
 {
 	const float inverse_mass_a = bodyA->GetInverseMass();
 	const float inverse_mass_b = bodyB->GetInverseMass();
 
-	const float elasticity = bodyA->elasticity * bodyB->elasticity;
-
 	const Vec3 r_a = worldContactA - bodyA->GetWorldMassCenter();
 	const Vec3 r_b = worldContactB - bodyB->GetWorldMassCenter();
 
@@ -19,17 +18,22 @@ void Contact::Resolve()
 
 	const Vec3 velocity_a = bodyA->linearVelocity + bodyA->angularVelocity.Cross( r_a );
 	const Vec3 velocity_b = bodyB->linearVelocity + bodyB->angularVelocity.Cross( r_b );
+	velocity_ab = velocity_a - velocity_b;
 
-	//  collision impulse
-	const Vec3 velocity_ab = velocity_a - velocity_b;
-	const float impulse_force = ( 1.0f + elasticity ) * velocity_ab.Dot( normal )
-		                      / ( inverse_mass_a + inverse_mass_b + angular_factor );
-	const Vec3 impulse = normal * impulse_force;
+	return inverse_mass_a + inverse_mass_b + angular_factor;
+}
 
-	bodyA->ApplyImpulse( worldContactA, impulse * -1.0f );
-	bodyB->ApplyImpulse( worldContactB, impulse );
+Vec3 Contact::ApplyFriction( const Vec3& velocity_ab )
+{
+	const float inverse_mass_a = bodyA->GetInverseMass();
+	const float inverse_mass_b = bodyB->GetInverseMass();
+
+	const Vec3 r_a = worldContactA - bodyA->GetWorldMassCenter();
+	const Vec3 r_b = worldContactB - bodyB->GetWorldMassCenter();
+
+	const Mat3 inverse_inertia_a = bodyA->GetWorldInverseInertiaTensor();
+	const Mat3 inverse_inertia_b = bodyB->GetWorldInverseInertiaTensor();
 
-	//  friction
 	const float friction = bodyA->friction * bodyB->friction;
 	const Vec3 velocity_normal = normal * normal.Dot( velocity_ab );
 	const Vec3 velocity_tangent = velocity_ab - velocity_normal;
@@ -44,14 +48,93 @@ void Contact::Resolve()
 	bodyA->ApplyImpulse( worldContactA, impulse_friction * -1.0f );
 	bodyB->ApplyImpulse( worldContactB, impulse_friction );
 
-	if ( impactTime == 0.0f )
+	return impulse_friction;
+}
+
+void Contact::Resolve()
+{
+	const float elasticity = bodyA->elasticity * bodyB->elasticity;
+
+	Vec3 velocity_ab;
+	const float normal_mass = ComputeNormalMass( velocity_ab );
+
+	//  collision impulse
+	const float impulse_force = ( 1.0f + elasticity ) * velocity_ab.Dot( normal ) / normal_mass;
+	if ( isPersistent && impulse_force >= 0.0f )
 	{
-		//  fix contact positions
-		const float time_a = inverse_mass_a / ( inverse_mass_a + inverse_mass_b );
-		const float time_b = inverse_mass_b / ( inverse_mass_a + inverse_mass_b );
-		const Vec3 d = worldContactB - worldContactA;
+		//  the pair is already separating at this point, it must not be pulled back
+		StoreImpulses( 0.0f, Vec3( 0.0f ) );
+		return;
+	}
+
+	const Vec3 impulse = normal * impulse_force;
+
+	bodyA->ApplyImpulse( worldContactA, impulse * -1.0f );
+	bodyB->ApplyImpulse( worldContactB, impulse );
 
-		bodyA->position += d * time_a;
-		bodyB->position -= d * time_b;
+	//  friction
+	const Vec3 impulse_friction = ApplyFriction( velocity_ab );
+
+	StoreImpulses( impulse_force, impulse_friction );
+
+	if ( impactTime == 0.0f && !isPersistent )
+	{
+		FixPositions();
+	}
+}
+
+void Contact::ResolveSpeculative( const float dt )
+{
+	//  bounce once touching, before that only the approach past the gap is removed
+	const bool is_touching = separationDistance <= 0.0f;
+	const float elasticity = is_touching ? bodyA->elasticity * bodyB->elasticity : 0.0f;
+	const float gap_velocity = is_touching ? 0.0f : separationDistance / dt;
+
+	Vec3 velocity_ab;
+	const float normal_mass = ComputeNormalMass( velocity_ab );
+
+	//  normal goes from b to a, a negative impulse pushes them apart
+	const float impulse_force = ( ( 1.0f + elasticity ) * velocity_ab.Dot( normal ) + gap_velocity ) / normal_mass;
+	if ( impulse_force >= 0.0f )
+	{
+		//  the gap won't be closed within this step
+		StoreImpulses( 0.0f, Vec3( 0.0f ) );
+		return;
 	}
+
+	const Vec3 impulse = normal * impulse_force;
+	bodyA->ApplyImpulse( worldContactA, impulse * -1.0f );
+	bodyB->ApplyImpulse( worldContactB, impulse );
+
+	const Vec3 impulse_friction = ApplyFriction( velocity_ab );
+
+	StoreImpulses( impulse_force, impulse_friction );
+
+	if ( separationDistance < 0.0f && !isPersistent )
+	{
+		FixPositions();
+	}
+}
+
+void Contact::StoreImpulses( const float normal_impulse, const Vec3& tangent_impulse )
+{
+	if ( manifoldPoint == nullptr ) return;
+
+	manifoldPoint->normalImpulse = normal_impulse;
+	manifoldPoint->tangentImpulse = tangent_impulse;
+}
+
+void Contact::FixPositions()
+{
+	const float inverse_mass_a = bodyA->GetInverseMass();
+	const float inverse_mass_b = bodyB->GetInverseMass();
+
+	//  fix contact positions
+	const float time_a = inverse_mass_a / ( inverse_mass_a + inverse_mass_b );
+	const float time_b = inverse_mass_b / ( inverse_mass_a + inverse_mass_b );
+	const Vec3 d = worldContactB - worldContactA;
+
+	//  static bodies may be shared by concurrent islands, never write them
+	if ( !bodyA->IsStatic() ) bodyA->position += d * time_a;
+	if ( !bodyB->IsStatic() ) bodyB->position -= d * time_b;
 }
@@ -1,6 +1,15 @@
 #pragma once
 #include "Body.h"
 
+class ManifoldPoint;
+
+//  how a scene turns continuous collisions into contacts
+enum class ContactMode
+{
+	TimeOfImpact,	//  contacts sorted by impact time, the world is stepped from one to the next
+	Speculative,	//  contacts of the current positions, approach limited to the gap in a single pass
+};
+
 class Contact
 {
 public:
@@ -16,10 +25,25 @@ public:
 	Body* bodyA { nullptr };
 	Body* bodyB { nullptr };
 
+	ManifoldPoint* manifoldPoint { nullptr };	//  receives the applied impulses, if any
+	bool isPersistent { false };				//  kept by a manifold from a previous step, positions aren't fixed from it
+	bool isSpeculative { false };				//  may still be separated, see ResolveSpeculative
+
 	void Resolve();
+	//  velocity constraint letting bodies close the separation distance within dt, but no more
+	void ResolveSpeculative( const float dt );
+	//  push resting bodies out of each other, only meant for contacts at impact time 0
+	void FixPositions();
+	void StoreImpulses( const float normal_impulse, const Vec3& tangent_impulse );
 
 	static bool Compare( const Contact& a, const Contact& b )
 	{
 		return a.impactTime < b.impactTime;
 	}
+
+private:
+	//  relative velocity at the contact points and the mass resisting it along the normal
+	float ComputeNormalMass( Vec3& velocity_ab ) const;
+	//  returns the impulse applied to b, a gets the opposite
+	Vec3 ApplyFriction( const Vec3& velocity_ab );
 };
\ No newline at end of file
@@ -0,0 +1,358 @@
+#include "ContactBatch.h"
+#include "Math/Simd.h"
+
+#include <algorithm>
+
+/*
+====================================================
+ContactLanes
+
+Gathered data of up to SIMD_WIDTH contacts, one array
+entry per lane
+====================================================
+*/
+struct ContactLanes
+{
+	float inverseMassA[SIMD_WIDTH];
+	float inverseMassB[SIMD_WIDTH];
+	float elasticity[SIMD_WIDTH];
+	float friction[SIMD_WIDTH];
+	float gapVelocity[SIMD_WIDTH];
+	float isSpeculative[SIMD_WIDTH];	//  1 for speculative contacts, 0 otherwise
+	float isPersistent[SIMD_WIDTH];		//  1 for contacts kept by a manifold, 0 otherwise
+
+	float normal[3][SIMD_WIDTH];
+	float rA[3][SIMD_WIDTH];
+	float rB[3][SIMD_WIDTH];
+	float inverseInertiaA[9][SIMD_WIDTH];
+	float inverseInertiaB[9][SIMD_WIDTH];
+
+	float linearVelocityA[3][SIMD_WIDTH];
+	float angularVelocityA[3][SIMD_WIDTH];
+	float linearVelocityB[3][SIMD_WIDTH];
+	float angularVelocityB[3][SIMD_WIDTH];
+};
+
+/*
+====================================================
+VelocityChangeLanes
+====================================================
+*/
+struct VelocityChangeLanes
+{
+	float impulse[3][SIMD_WIDTH];	//  applied to b, a gets the opposite
+	float linearA[3][SIMD_WIDTH];
+	float angularA[3][SIMD_WIDTH];
+	float linearB[3][SIMD_WIDTH];
+	float angularB[3][SIMD_WIDTH];
+};
+
+static void SetLane( float ( &lanes )[3][SIMD_WIDTH], const int lane, const Vec3& value )
+{
+	lanes[0][lane] = value.x;
+	lanes[1][lane] = value.y;
+	lanes[2][lane] = value.z;
+}
+
+static void SetLane( float ( &lanes )[9][SIMD_WIDTH], const int lane, const Mat3& value )
+{
+	for ( int i = 0; i < 3; i++ )
+	{
+		lanes[i * 3 + 0][lane] = value.rows[i].x;
+		lanes[i * 3 + 1][lane] = value.rows[i].y;
+		lanes[i * 3 + 2][lane] = value.rows[i].z;
+	}
+}
+
+static Vec3 GetLane( const float ( &lanes )[3][SIMD_WIDTH], const int lane )
+{
+	return Vec3( lanes[0][lane], lanes[1][lane], lanes[2][lane] );
+}
+
+static SimdVec3 LoadLanes( const float ( &lanes )[3][SIMD_WIDTH] )
+{
+	return SimdVec3::Load( lanes[0], lanes[1], lanes[2] );
+}
+
+static SimdMat3 LoadLanes( const float ( &lanes )[9][SIMD_WIDTH] )
+{
+	SimdMat3 matrix;
+	for ( int i = 0; i < 3; i++ )
+	{
+		matrix.rows[i] = SimdVec3::Load( lanes[i * 3 + 0], lanes[i * 3 + 1], lanes[i * 3 + 2] );
+	}
+	return matrix;
+}
+
+static void StoreLanes( float ( &lanes )[3][SIMD_WIDTH], const SimdVec3& value )
+{
+	value.Store( lanes[0], lanes[1], lanes[2] );
+}
+
+/*
+====================================================
+GatherLanes
+====================================================
+*/
+static void GatherLanes( Contact* const* contacts, const int count, const float dt, ContactLanes& lanes )
+{
+	Mat3 zero_matrix;
+	zero_matrix.Zero();
+
+	for ( int lane = 0; lane < SIMD_WIDTH; lane++ )
+	{
+		if ( lane >= count )
+		{
+			//  padding lanes, only there to keep the maths finite
+			lanes.inverseMassA[lane] = 1.0f;
+			lanes.inverseMassB[lane] = 1.0f;
+			lanes.elasticity[lane] = 0.0f;
+			lanes.friction[lane] = 0.0f;
+			lanes.gapVelocity[lane] = 0.0f;
+			lanes.isSpeculative[lane] = 0.0f;
+			lanes.isPersistent[lane] = 0.0f;
+			SetLane( lanes.normal, lane, Vec3( 1.0f, 0.0f, 0.0f ) );
+			SetLane( lanes.rA, lane, Vec3( 0.0f ) );
+			SetLane( lanes.rB, lane, Vec3( 0.0f ) );
+			SetLane( lanes.inverseInertiaA, lane, zero_matrix );
+			SetLane( lanes.inverseInertiaB, lane, zero_matrix );
+			SetLane( lanes.linearVelocityA, lane, Vec3( 0.0f ) );
+			SetLane( lanes.angularVelocityA, lane, Vec3( 0.0f ) );
+			SetLane( lanes.linearVelocityB, lane, Vec3( 0.0f ) );
+			SetLane( lanes.angularVelocityB, lane, Vec3( 0.0f ) );
+			continue;
+		}
+
+		const Contact& contact = *contacts[lane];
+		const Body& body_a = *contact.bodyA;
+		const Body& body_b = *contact.bodyB;
+
+		lanes.inverseMassA[lane] = body_a.GetInverseMass();
+		lanes.inverseMassB[lane] = body_b.GetInverseMass();
+		lanes.elasticity[lane] = body_a.elasticity * body_b.elasticity;
+		lanes.friction[lane] = body_a.friction * body_b.friction;
+		lanes.gapVelocity[lane] = 0.0f;
+		lanes.isSpeculative[lane] = contact.isSpeculative ? 1.0f : 0.0f;
+		lanes.isPersistent[lane] = contact.isPersistent ? 1.0f : 0.0f;
+
+		//  see Contact::ResolveSpeculative
+		if ( contact.isSpeculative && contact.separationDistance > 0.0f )
+		{
+			lanes.elasticity[lane] = 0.0f;
+			lanes.gapVelocity[lane] = contact.separationDistance / dt;
+		}
+
+		SetLane( lanes.normal, lane, contact.normal );
+		SetLane( lanes.rA, lane, contact.worldContactA - body_a.GetWorldMassCenter() );
+		SetLane( lanes.rB, lane, contact.worldContactB - body_b.GetWorldMassCenter() );
+		SetLane( lanes.inverseInertiaA, lane, body_a.GetWorldInverseInertiaTensor() );
+		SetLane( lanes.inverseInertiaB, lane, body_b.GetWorldInverseInertiaTensor() );
+
+		SetLane( lanes.linearVelocityA, lane, body_a.linearVelocity );
+		SetLane( lanes.angularVelocityA, lane, body_a.angularVelocity );
+		SetLane( lanes.linearVelocityB, lane, body_b.linearVelocity );
+		SetLane( lanes.angularVelocityB, lane, body_b.angularVelocity );
+	}
+}
+
+/*
+====================================================
+ComputeVelocityChanges
+
+Contact::Resolve or Contact::ResolveSpeculative, one contact per lane
+====================================================
+*/
+static void ComputeVelocityChanges( const ContactLanes& lanes, VelocityChangeLanes& collision, VelocityChangeLanes& friction, float ( &normal_impulse )[SIMD_WIDTH] )
+{
+	const SimdFloat zero = SimdFloat::Broadcast( 0.0f );
+	const SimdFloat one = SimdFloat::Broadcast( 1.0f );
+
+	const SimdFloat inverse_mass_a = SimdFloat::Load( lanes.inverseMassA );
+	const SimdFloat inverse_mass_b = SimdFloat::Load( lanes.inverseMassB );
+	const SimdFloat elasticity = SimdFloat::Load( lanes.elasticity );
+
+	const SimdVec3 normal = LoadLanes( lanes.normal );
+	const SimdVec3 r_a = LoadLanes( lanes.rA );
+	const SimdVec3 r_b = LoadLanes( lanes.rB );
+	const SimdMat3 inverse_inertia_a = LoadLanes( lanes.inverseInertiaA );
+	const SimdMat3 inverse_inertia_b = LoadLanes( lanes.inverseInertiaB );
+
+	const SimdVec3 angular_a = ( inverse_inertia_a * r_a.Cross( normal ) ).Cross( r_a );
+	const SimdVec3 angular_b = ( inverse_inertia_b * r_b.Cross( normal ) ).Cross( r_b );
+	const SimdFloat angular_factor = ( angular_a + angular_b ).Dot( normal );
+
+	const SimdVec3 velocity_a = LoadLanes( lanes.linearVelocityA ) + LoadLanes( lanes.angularVelocityA ).Cross( r_a );
+	const SimdVec3 velocity_b = LoadLanes( lanes.linearVelocityB ) + LoadLanes( lanes.angularVelocityB ).Cross( r_b );
+
+	//  collision impulse
+	const SimdVec3 velocity_ab = velocity_a - velocity_b;
+	const SimdFloat impulse_force_raw = ( ( one + elasticity ) * velocity_ab.Dot( normal ) + SimdFloat::Load( lanes.gapVelocity ) )
+		                              / ( inverse_mass_a + inverse_mass_b + angular_factor );
+
+	//  speculative and persistent contacts only push apart, and not at all when the gap stays open
+	//  or the pair is already separating
+	const SimdFloat is_speculative = SimdFloat::Load( lanes.isSpeculative ).Greater( zero );
+	const SimdFloat is_persistent = SimdFloat::Load( lanes.isPersistent ).Greater( zero );
+	const SimdFloat is_idle = ( is_speculative | is_persistent ) & zero.LessEqual( impulse_force_raw );
+	const SimdFloat impulse_force = SimdFloat::Select( is_idle, zero, impulse_force_raw );
+	const SimdVec3 impulse = normal * impulse_force;
+	const SimdVec3 impulse_a = impulse * SimdFloat::Broadcast( -1.0f );
+
+	impulse_force.Store( normal_impulse );
+	StoreLanes( collision.impulse, impulse );
+	StoreLanes( collision.linearA, impulse_a * inverse_mass_a );
+	StoreLanes( collision.angularA, inverse_inertia_a * r_a.Cross( impulse_a ) );
+	StoreLanes( collision.linearB, impulse * inverse_mass_b );
+	StoreLanes( collision.angularB, inverse_inertia_b * r_b.Cross( impulse ) );
+
+	//  friction
+	const SimdVec3 velocity_normal = normal * normal.Dot( velocity_ab );
+	const SimdVec3 velocity_tangent = velocity_ab - velocity_normal;
+
+	//  same as Vec3::Normalize, a null tangent is left untouched
+	const SimdFloat inverse_length = one / SimdFloat::Sqrt( velocity_tangent.Dot( velocity_tangent ) );
+	const SimdFloat is_finite = ( zero * inverse_length ).Equal( zero * inverse_length );
+	const SimdVec3 relative_velocity_tangent = SimdVec3::Select( is_finite, velocity_tangent * inverse_length, velocity_tangent );
+
+	const SimdVec3 inertia_a = ( inverse_inertia_a * r_a.Cross( relative_velocity_tangent ) ).Cross( r_a );
+	const SimdVec3 inertia_b = ( inverse_inertia_b * r_b.Cross( relative_velocity_tangent ) ).Cross( r_b );
+	const SimdFloat inverse_inertia = ( inertia_a + inertia_b ).Dot( relative_velocity_tangent );
+
+	const SimdFloat reduced_mass = one / ( inverse_mass_a + inverse_mass_b + inverse_inertia );
+	const SimdFloat friction_factor = SimdFloat::Select( is_idle, zero, SimdFloat::Load( lanes.friction ) );
+	const SimdVec3 impulse_friction = velocity_tangent * ( reduced_mass * friction_factor );
+	const SimdVec3 impulse_friction_a = impulse_friction * SimdFloat::Broadcast( -1.0f );
+
+	StoreLanes( friction.impulse, impulse_friction );
+	StoreLanes( friction.linearA, impulse_friction_a * inverse_mass_a );
+	StoreLanes( friction.angularA, inverse_inertia_a * r_a.Cross( impulse_friction_a ) );
+	StoreLanes( friction.linearB, impulse_friction * inverse_mass_b );
+	StoreLanes( friction.angularB, inverse_inertia_b * r_b.Cross( impulse_friction ) );
+}
+
+/*
+====================================================
+ResolveLanes
+====================================================
+*/
+static void ResolveLanes( Contact* const* contacts, const int count, const float dt )
+{
+	ContactLanes lanes;
+	GatherLanes( contacts, count, dt, lanes );
+
+	VelocityChangeLanes collision, friction;
+	float normal_impulse[SIMD_WIDTH];
+	ComputeVelocityChanges( lanes, collision, friction, normal_impulse );
+
+	//  scatter, in the same order as Contact::Resolve so the angular clamp behaves the same
+	for ( int lane = 0; lane < count; lane++ )
+	{
+		Contact& contact = *contacts[lane];
+
+		contact.bodyA->ApplyVelocityChange( GetLane( collision.linearA, lane ), GetLane( collision.angularA, lane ) );
+		contact.bodyB->ApplyVelocityChange( GetLane( collision.linearB, lane ), GetLane( collision.angularB, lane ) );
+		contact.bodyA->ApplyVelocityChange( GetLane( friction.linearA, lane ), GetLane( friction.angularA, lane ) );
+		contact.bodyB->ApplyVelocityChange( GetLane( friction.linearB, lane ), GetLane( friction.angularB, lane ) );
+		contact.StoreImpulses( normal_impulse[lane], GetLane( friction.impulse, lane ) );
+
+		const bool is_resting = contact.isSpeculative
+			? contact.separationDistance < 0.0f && normal_impulse[lane] < 0.0f
+			: contact.impactTime == 0.0f;
+		if ( is_resting && !contact.isPersistent )
+		{
+			contact.FixPositions();
+		}
+	}
+}
+
+/*
+====================================================
+ContactBatch::Solve
+====================================================
+*/
+void ContactBatch::Solve( const float dt, JobSystem& job_system )
+{
+	const int count = (int) contacts.size();
+	Contact* const* data = contacts.data();
+
+	job_system.ParallelFor( count, CONTACT_BATCH_JOB_SIZE, [data, dt]( int begin, int end )
+		{
+			for ( int i = begin; i < end; i += SIMD_WIDTH )
+			{
+				ResolveLanes( data + i, std::min( SIMD_WIDTH, end - i ), dt );
+			}
+		} );
+}
+
+/*
+====================================================
+ContactBatches::Build
+====================================================
+*/
+void ContactBatches::Build( Contact* contacts, int count, const std::vector<Body>& world_bodies )
+{
+	const int max_colours = 64;
+
+	batches.clear();
+	leftovers.clear();
+	bodyColours.assign( world_bodies.size(), 0 );
+
+	for ( int i = 0; i < count; i++ )
+	{
+		Contact& contact = contacts[i];
+		const int id_a = (int) ( contact.bodyA - world_bodies.data() );
+		const int id_b = (int) ( contact.bodyB - world_bodies.data() );
+
+		//  static bodies are never written, they don't constrain the colour
+		unsigned long long used_colours = 0;
+		if ( !contact.bodyA->IsStatic() ) used_colours |= bodyColours[id_a];
+		if ( !contact.bodyB->IsStatic() ) used_colours |= bodyColours[id_b];
+
+		int colour = 0;
+		while ( colour < max_colours && ( used_colours & ( 1ull << colour ) ) )
+		{
+			colour++;
+		}
+
+		if ( colour == max_colours )
+		{
+			leftovers.push_back( &contact );
+			continue;
+		}
+
+		bodyColours[id_a] |= 1ull << colour;
+		bodyColours[id_b] |= 1ull << colour;
+
+		if ( colour >= (int) batches.size() )
+		{
+			batches.resize( colour + 1 );
+		}
+		batches[colour].contacts.push_back( &contact );
+	}
+}
+
+/*
+====================================================
+ContactBatches::Solve
+====================================================
+*/
+void ContactBatches::Solve( const float dt, JobSystem& job_system )
+{
+	//  a batch only reads velocities written by the previous ones
+	for ( ContactBatch& batch : batches )
+	{
+		batch.Solve( dt, job_system );
+	}
+
+	for ( Contact* contact : leftovers )
+	{
+		if ( contact->isSpeculative )
+		{
+			contact->ResolveSpeculative( dt );
+		}
+		else
+		{
+			contact->Resolve();
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+
+#include "Body.h"
+#include "Contact.h"
+#include "JobSystem.h"
+
+//  contacts sharing the same impact time needed before colouring them pays off
+const int CONTACT_BATCH_MIN_CONTACTS = 16;
+//  contacts of a single colour solved by a single job
+const int CONTACT_BATCH_JOB_SIZE = 64;
+
+/*
+====================================================
+ContactBatch
+
+Contacts of a single colour: no dynamic body is shared
+between them, so they are resolved together in SIMD lanes
+and split across threads without any lock.
+====================================================
+*/
+class ContactBatch
+{
+public:
+	std::vector<Contact*> contacts;
+
+	//  dt is the step speculative contacts close their gap in
+	void Solve( const float dt, JobSystem& job_system );
+};
+
+/*
+====================================================
+ContactBatches
+
+Greedy graph colouring of contacts happening at the same
+time. Contacts left once every colour is taken by one of
+their bodies are resolved sequentially, after the batches.
+====================================================
+*/
+class ContactBatches
+{
+public:
+	void Build( Contact* contacts, int count, const std::vector<Body>& world_bodies );
+	void Solve( const float dt, JobSystem& job_system );
+
+private:
+	std::vector<ContactBatch> batches;
+	std::vector<Contact*> leftovers;
+	std::vector<unsigned long long> bodyColours;	//  used colours bitmask, by body id
+};
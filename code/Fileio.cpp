@@ -10,6 +10,9 @@
 #include <direct.h>
 #define GetCurrentDir _getcwd
 
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
 static char g_ApplicationDirectory[ FILENAME_MAX ];
 static bool g_WasInitialized = false;
 
@@ -139,4 +142,71 @@ bool SaveFileData( const char * fileNameLocal, const void * data, unsigned int s
 	fclose( file );
 	printf( "Write file was success %s\n", fileName );
 	return true;
+}
+
+/*
+====================================================
+MapFileData
+Maps the whole file read only, no copy is made
+====================================================
+*/
+bool MapFileData( const char * fileNameLocal, mappedFile_t & file ) {
+	InitializeFileSystem();
+	memset( &file, 0, sizeof( file ) );
+
+	char fileName[ 2048 ];
+	sprintf( fileName, "%s/%s", g_ApplicationDirectory, fileNameLocal );
+
+	HANDLE fileHandle = CreateFileA( fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( INVALID_HANDLE_VALUE == fileHandle ) {
+		return false;
+	}
+
+	// An empty file can't be mapped
+	const DWORD size = GetFileSize( fileHandle, NULL );
+	if ( INVALID_FILE_SIZE == size || 0 == size ) {
+		printf( "ERROR: Unable to map empty file %s\n", fileName );
+		CloseHandle( fileHandle );
+		return false;
+	}
+
+	HANDLE mappingHandle = CreateFileMappingA( fileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( NULL == mappingHandle ) {
+		printf( "ERROR: Unable to map file %s\n", fileName );
+		CloseHandle( fileHandle );
+		return false;
+	}
+
+	const void * data = MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 );
+	if ( NULL == data ) {
+		printf( "ERROR: Unable to map file %s\n", fileName );
+		CloseHandle( mappingHandle );
+		CloseHandle( fileHandle );
+		return false;
+	}
+
+	file.data = (const unsigned char *)data;
+	file.size = size;
+	file.fileHandle = fileHandle;
+	file.mappingHandle = mappingHandle;
+	printf( "Map file was success %s\n", fileName );
+	return true;
+}
+
+/*
+====================================================
+UnmapFileData
+====================================================
+*/
+void UnmapFileData( mappedFile_t & file ) {
+	if ( NULL != file.data ) {
+		UnmapViewOfFile( file.data );
+	}
+	if ( NULL != file.mappingHandle ) {
+		CloseHandle( (HANDLE)file.mappingHandle );
+	}
+	if ( NULL != file.fileHandle ) {
+		CloseHandle( (HANDLE)file.fileHandle );
+	}
+	memset( &file, 0, sizeof( file ) );
 }
\ No newline at end of file
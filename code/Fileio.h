@@ -4,4 +4,21 @@
 #pragma once
 
 bool GetFileData( const char * fileName, unsigned char ** data, unsigned int & size );
-bool SaveFileData( const char * fileName, const void * data, unsigned int size );
\ No newline at end of file
+bool SaveFileData( const char * fileName, const void * data, unsigned int size );
+
+/*
+====================================================
+mappedFile_t
+
+Read only view of a whole file, mapped in memory
+====================================================
+*/
+struct mappedFile_t {
+	const unsigned char * data;
+	unsigned int size;
+	void * fileHandle;
+	void * mappingHandle;
+};
+
+bool MapFileData( const char * fileName, mappedFile_t & file );
+void UnmapFileData( mappedFile_t & file );
\ No newline at end of file
@@ -0,0 +1,588 @@
+#include "GJK.h"
+
+#include <algorithm>
+
+struct SupportPoint
+{
+	Vec3 xyz;	//  point on the Minkowski difference
+	Vec3 pointA;
+	Vec3 pointB;
+};
+
+static SupportPoint Support( const ShapePose& a, const ShapePose& b, Vec3 dir, const float bias )
+{
+	dir.Normalize();
+
+	SupportPoint point;
+	point.pointA = a.shape->Support( dir, a.position, a.orientation, bias );
+	point.pointB = b.shape->Support( dir * -1.0f, b.position, b.orientation, bias );
+	point.xyz = point.pointA - point.pointB;
+	return point;
+}
+
+static Vec3 GetStartDirection( const Vec3* separating_axis )
+{
+	if ( separating_axis != nullptr && separating_axis->GetLengthSqr() > 1e-12f )
+	{
+		return *separating_axis;
+	}
+
+	return Vec3( 1.0f, 1.0f, 1.0f );
+}
+
+static bool CompareSigns( const float a, const float b )
+{
+	return ( a > 0.0f && b > 0.0f ) || ( a < 0.0f && b < 0.0f );
+}
+
+/*
+====================================================
+SignedVolume1D
+
+Barycentric coordinates of the closest point to the origin
+on the segment
+====================================================
+*/
+static Vec2 SignedVolume1D( const Vec3& s1, const Vec3& s2 )
+{
+	const Vec3 ab = s2 - s1;
+	const Vec3 ap = s1 * -1.0f;
+	const Vec3 p0 = s1 + ab * ab.Dot( ap ) / ab.GetLengthSqr();
+
+	//  project on the axis with the biggest length
+	int axis = 0;
+	float mu_max = 0.0f;
+	for ( int i = 0; i < 3; i++ )
+	{
+		const float mu = s2[i] - s1[i];
+		if ( mu * mu > mu_max * mu_max )
+		{
+			mu_max = mu;
+			axis = i;
+		}
+	}
+
+	const float a = s1[axis];
+	const float b = s2[axis];
+	const float p = p0[axis];
+
+	//  origin projection is inside the segment
+	if ( ( p > a && p < b ) || ( p > b && p < a ) )
+	{
+		return Vec2( ( b - p ) / mu_max, ( p - a ) / mu_max );
+	}
+
+	//  on the side of a
+	if ( ( a <= b && p <= a ) || ( a >= b && p >= a ) )
+	{
+		return Vec2( 1.0f, 0.0f );
+	}
+
+	return Vec2( 0.0f, 1.0f );
+}
+
+/*
+====================================================
+SignedVolume2D
+====================================================
+*/
+static Vec3 SignedVolume2D( const Vec3& s1, const Vec3& s2, const Vec3& s3 )
+{
+	const Vec3 normal = ( s2 - s1 ).Cross( s3 - s1 );
+	const Vec3 p0 = normal * s1.Dot( normal ) / normal.GetLengthSqr();
+
+	//  project on the plane with the biggest area
+	int axis = 0;
+	float area_max = 0.0f;
+	for ( int i = 0; i < 3; i++ )
+	{
+		const int j = ( i + 1 ) % 3;
+		const int k = ( i + 2 ) % 3;
+
+		const Vec2 a = Vec2( s1[j], s1[k] );
+		const Vec2 ab = Vec2( s2[j], s2[k] ) - a;
+		const Vec2 ac = Vec2( s3[j], s3[k] ) - a;
+
+		const float area = ab.x * ac.y - ab.y * ac.x;
+		if ( area * area > area_max * area_max )
+		{
+			axis = i;
+			area_max = area;
+		}
+	}
+
+	const int x = ( axis + 1 ) % 3;
+	const int y = ( axis + 2 ) % 3;
+	const Vec2 s[3] = { Vec2( s1[x], s1[y] ), Vec2( s2[x], s2[y] ), Vec2( s3[x], s3[y] ) };
+	const Vec2 p = Vec2( p0[x], p0[y] );
+
+	//  areas of the sub-triangles made with the projected origin
+	Vec3 areas;
+	for ( int i = 0; i < 3; i++ )
+	{
+		const Vec2 ab = s[( i + 1 ) % 3] - p;
+		const Vec2 ac = s[( i + 2 ) % 3] - p;
+		areas[i] = ab.x * ac.y - ab.y * ac.x;
+	}
+
+	if ( CompareSigns( area_max, areas[0] ) && CompareSigns( area_max, areas[1] ) && CompareSigns( area_max, areas[2] ) )
+	{
+		return areas / area_max;
+	}
+
+	//  closest point is on an edge
+	const Vec3 points[3] = { s1, s2, s3 };
+	float min_distance = 1e10f;
+	Vec3 lambdas = Vec3( 1.0f, 0.0f, 0.0f );
+	for ( int i = 0; i < 3; i++ )
+	{
+		const int k = ( i + 1 ) % 3;
+		const int l = ( i + 2 ) % 3;
+
+		const Vec2 edge_lambdas = SignedVolume1D( points[k], points[l] );
+		const Vec3 point = points[k] * edge_lambdas[0] + points[l] * edge_lambdas[1];
+		if ( point.GetLengthSqr() < min_distance )
+		{
+			min_distance = point.GetLengthSqr();
+			lambdas[i] = 0.0f;
+			lambdas[k] = edge_lambdas[0];
+			lambdas[l] = edge_lambdas[1];
+		}
+	}
+
+	return lambdas;
+}
+
+/*
+====================================================
+SignedVolume3D
+====================================================
+*/
+static Vec4 SignedVolume3D( const Vec3& s1, const Vec3& s2, const Vec3& s3, const Vec3& s4 )
+{
+	Mat4 m;
+	m.rows[0] = Vec4( s1.x, s2.x, s3.x, s4.x );
+	m.rows[1] = Vec4( s1.y, s2.y, s3.y, s4.y );
+	m.rows[2] = Vec4( s1.z, s2.z, s3.z, s4.z );
+	m.rows[3] = Vec4( 1.0f, 1.0f, 1.0f, 1.0f );
+
+	Vec4 cofactors;
+	for ( int i = 0; i < 4; i++ )
+	{
+		cofactors[i] = m.Cofactor( 3, i );
+	}
+
+	const float determinant = cofactors[0] + cofactors[1] + cofactors[2] + cofactors[3];
+	if ( CompareSigns( determinant, cofactors[0] ) && CompareSigns( determinant, cofactors[1] )
+	  && CompareSigns( determinant, cofactors[2] ) && CompareSigns( determinant, cofactors[3] ) )
+	{
+		return cofactors * ( 1.0f / determinant );
+	}
+
+	//  closest point is on a face
+	const Vec3 points[4] = { s1, s2, s3, s4 };
+	float min_distance = 1e10f;
+	Vec4 lambdas;
+	lambdas.Zero();
+	for ( int i = 0; i < 4; i++ )
+	{
+		const int j = ( i + 1 ) % 4;
+		const int k = ( i + 2 ) % 4;
+
+		const Vec3 face_lambdas = SignedVolume2D( points[i], points[j], points[k] );
+		const Vec3 point = points[i] * face_lambdas[0] + points[j] * face_lambdas[1] + points[k] * face_lambdas[2];
+		if ( point.GetLengthSqr() < min_distance )
+		{
+			min_distance = point.GetLengthSqr();
+			lambdas.Zero();
+			lambdas[i] = face_lambdas[0];
+			lambdas[j] = face_lambdas[1];
+			lambdas[k] = face_lambdas[2];
+		}
+	}
+
+	return lambdas;
+}
+
+/*
+====================================================
+SimplexSignedVolumes
+
+Closest point of the simplex to the origin, returns true
+once the origin is inside
+====================================================
+*/
+static bool SimplexSignedVolumes( const SupportPoint* points, const int count, Vec3& new_dir, Vec4& lambdas )
+{
+	const float epsilon = 0.0001f * 0.0001f;
+	lambdas.Zero();
+
+	switch ( count )
+	{
+	default:
+	case 2:
+	{
+		const Vec2 result = SignedVolume1D( points[0].xyz, points[1].xyz );
+		lambdas[0] = result[0];
+		lambdas[1] = result[1];
+		break;
+	}
+	case 3:
+	{
+		const Vec3 result = SignedVolume2D( points[0].xyz, points[1].xyz, points[2].xyz );
+		lambdas[0] = result[0];
+		lambdas[1] = result[1];
+		lambdas[2] = result[2];
+		break;
+	}
+	case 4:
+		lambdas = SignedVolume3D( points[0].xyz, points[1].xyz, points[2].xyz, points[3].xyz );
+		break;
+	}
+
+	Vec3 closest = Vec3( 0.0f );
+	for ( int i = 0; i < count; i++ )
+	{
+		closest += points[i].xyz * lambdas[i];
+	}
+
+	new_dir = closest * -1.0f;
+	return closest.GetLengthSqr() < epsilon;
+}
+
+static bool HasPoint( const SupportPoint* points, const int count, const SupportPoint& new_point )
+{
+	const float precision = 1e-6f;
+	for ( int i = 0; i < count; i++ )
+	{
+		if ( ( points[i].xyz - new_point.xyz ).GetLengthSqr() < precision * precision ) return true;
+	}
+	return false;
+}
+
+//  drop the points not taking part in the closest point, returns the remaining count
+static int SortValids( SupportPoint* points, Vec4& lambdas )
+{
+	SupportPoint valid_points[4];
+	Vec4 valid_lambdas;
+	valid_lambdas.Zero();
+
+	int count = 0;
+	for ( int i = 0; i < 4; i++ )
+	{
+		if ( lambdas[i] == 0.0f ) continue;
+
+		valid_points[count] = points[i];
+		valid_lambdas[count] = lambdas[i];
+		count++;
+	}
+
+	for ( int i = 0; i < 4; i++ )
+	{
+		points[i] = valid_points[i];
+	}
+	lambdas = valid_lambdas;
+	return count;
+}
+
+/*
+====================================================
+EPA
+====================================================
+*/
+static Vec3 BarycentricCoordinates( Vec3 s1, Vec3 s2, Vec3 s3, const Vec3& point )
+{
+	s1 = s1 - point;
+	s2 = s2 - point;
+	s3 = s3 - point;
+
+	Vec3 lambdas = SignedVolume2D( s1, s2, s3 );
+	if ( !lambdas.IsValid() )
+	{
+		lambdas = Vec3( 1.0f, 0.0f, 0.0f );
+	}
+	return lambdas;
+}
+
+static Vec3 NormalDirection( const tri_t& tri, const std::vector<SupportPoint>& points )
+{
+	const Vec3& a = points[tri.a].xyz;
+	const Vec3& b = points[tri.b].xyz;
+	const Vec3& c = points[tri.c].xyz;
+
+	Vec3 normal = ( b - a ).Cross( c - a );
+	normal.Normalize();
+	return normal;
+}
+
+static float SignedDistanceToTriangle( const tri_t& tri, const Vec3& point, const std::vector<SupportPoint>& points )
+{
+	const Vec3 normal = NormalDirection( tri, points );
+	return normal.Dot( point - points[tri.a].xyz );
+}
+
+static int ClosestTriangle( const std::vector<tri_t>& tris, const std::vector<SupportPoint>& points )
+{
+	float min_distance = 1e10f;
+	int closest_id = -1;
+	for ( int i = 0; i < (int) tris.size(); i++ )
+	{
+		const float distance = SignedDistanceToTriangle( tris[i], Vec3( 0.0f ), points );
+		if ( distance * distance < min_distance )
+		{
+			closest_id = i;
+			min_distance = distance * distance;
+		}
+	}
+	return closest_id;
+}
+
+static bool HasPoint( const Vec3& point, const std::vector<tri_t>& tris, const std::vector<SupportPoint>& points )
+{
+	const float epsilon = 0.001f * 0.001f;
+	for ( const tri_t& tri : tris )
+	{
+		if ( ( point - points[tri.a].xyz ).GetLengthSqr() < epsilon ) return true;
+		if ( ( point - points[tri.b].xyz ).GetLengthSqr() < epsilon ) return true;
+		if ( ( point - points[tri.c].xyz ).GetLengthSqr() < epsilon ) return true;
+	}
+	return false;
+}
+
+static int RemoveTrianglesFacingPoint( const Vec3& point, std::vector<tri_t>& tris, const std::vector<SupportPoint>& points )
+{
+	int removed_count = 0;
+	for ( int i = 0; i < (int) tris.size(); i++ )
+	{
+		if ( SignedDistanceToTriangle( tris[i], point, points ) <= 0.0f ) continue;
+
+		tris.erase( tris.begin() + i );
+		i--;
+		removed_count++;
+	}
+	return removed_count;
+}
+
+static void FindDanglingEdges( std::vector<edge_t>& dangling_edges, const std::vector<tri_t>& tris )
+{
+	dangling_edges.clear();
+
+	for ( int i = 0; i < (int) tris.size(); i++ )
+	{
+		const tri_t& tri = tris[i];
+		const edge_t edges[3] = { { tri.a, tri.b }, { tri.b, tri.c }, { tri.c, tri.a } };
+		int counts[3] = { 0, 0, 0 };
+
+		for ( int j = 0; j < (int) tris.size(); j++ )
+		{
+			if ( j == i ) continue;
+
+			const tri_t& other = tris[j];
+			const edge_t other_edges[3] = { { other.a, other.b }, { other.b, other.c }, { other.c, other.a } };
+			for ( int k = 0; k < 3; k++ )
+			{
+				for ( int l = 0; l < 3; l++ )
+				{
+					if ( edges[k] == other_edges[l] ) counts[k]++;
+				}
+			}
+		}
+
+		for ( int k = 0; k < 3; k++ )
+		{
+			if ( counts[k] == 0 ) dangling_edges.push_back( edges[k] );
+		}
+	}
+}
+
+//  expand a simplex containing the origin until reaching the closest face of the Minkowski difference
+static void EPA_Expand( const ShapePose& a, const ShapePose& b, const float bias, const SupportPoint simplex[4], Vec3& point_a, Vec3& point_b )
+{
+	std::vector<SupportPoint> points;
+	std::vector<tri_t> tris;
+	std::vector<edge_t> dangling_edges;
+
+	Vec3 center = Vec3( 0.0f );
+	for ( int i = 0; i < 4; i++ )
+	{
+		points.push_back( simplex[i] );
+		center += simplex[i].xyz;
+	}
+	center *= 0.25f;
+
+	//  tetrahedron faces, pointing outward
+	for ( int i = 0; i < 4; i++ )
+	{
+		tri_t tri = { i, ( i + 1 ) % 4, ( i + 2 ) % 4 };
+		const int unused_point = ( i + 3 ) % 4;
+		if ( SignedDistanceToTriangle( tri, points[unused_point].xyz, points ) > 0.0f )
+		{
+			std::swap( tri.a, tri.b );
+		}
+		tris.push_back( tri );
+	}
+
+	while ( true )
+	{
+		const int closest_id = ClosestTriangle( tris, points );
+		const Vec3 normal = NormalDirection( tris[closest_id], points );
+
+		const SupportPoint new_point = Support( a, b, normal, bias );
+
+		//  can't expand further
+		if ( HasPoint( new_point.xyz, tris, points ) ) break;
+		if ( SignedDistanceToTriangle( tris[closest_id], new_point.xyz, points ) <= 0.0f ) break;
+
+		const int new_id = (int) points.size();
+		points.push_back( new_point );
+
+		if ( RemoveTrianglesFacingPoint( new_point.xyz, tris, points ) == 0 ) break;
+
+		FindDanglingEdges( dangling_edges, tris );
+		if ( dangling_edges.empty() ) break;
+
+		//  close the hole with the new point
+		for ( const edge_t& edge : dangling_edges )
+		{
+			tri_t tri = { new_id, edge.b, edge.a };
+			if ( SignedDistanceToTriangle( tri, center, points ) > 0.0f )
+			{
+				std::swap( tri.b, tri.c );
+			}
+			tris.push_back( tri );
+		}
+	}
+
+	const tri_t& tri = tris[ClosestTriangle( tris, points )];
+	const Vec3 lambdas = BarycentricCoordinates( points[tri.a].xyz, points[tri.b].xyz, points[tri.c].xyz, Vec3( 0.0f ) );
+
+	point_a = points[tri.a].pointA * lambdas[0] + points[tri.b].pointA * lambdas[1] + points[tri.c].pointA * lambdas[2];
+	point_b = points[tri.a].pointB * lambdas[0] + points[tri.b].pointB * lambdas[1] + points[tri.c].pointB * lambdas[2];
+}
+
+/*
+====================================================
+GJK_DoesIntersect
+====================================================
+*/
+bool GJK_DoesIntersect( const ShapePose& a, const ShapePose& b, const float bias, Vec3& point_a, Vec3& point_b, Vec3* separating_axis )
+{
+	SupportPoint simplex[4];
+	int count = 1;
+	simplex[0] = Support( a, b, GetStartDirection( separating_axis ), 0.0f );
+
+	float closest_distance = 1e10f;
+	bool does_contain_origin = false;
+	Vec3 new_dir = simplex[0].xyz * -1.0f;
+	do
+	{
+		const SupportPoint new_point = Support( a, b, new_dir, 0.0f );
+		if ( HasPoint( simplex, count, new_point ) ) break;
+
+		simplex[count] = new_point;
+		count++;
+
+		//  new point didn't go past the origin, shapes are separated
+		if ( new_dir.Dot( new_point.xyz ) < 0.0f ) break;
+
+		Vec4 lambdas;
+		does_contain_origin = SimplexSignedVolumes( simplex, count, new_dir, lambdas );
+		if ( does_contain_origin ) break;
+
+		const float distance = new_dir.GetLengthSqr();
+		if ( distance >= closest_distance ) break;
+		closest_distance = distance;
+
+		count = SortValids( simplex, lambdas );
+		does_contain_origin = count == 4;
+	} while ( !does_contain_origin );
+
+	if ( separating_axis != nullptr )
+	{
+		*separating_axis = new_dir;
+	}
+
+	if ( !does_contain_origin ) return false;
+
+	//  EPA needs a tetrahedron
+	if ( count == 1 )
+	{
+		simplex[count++] = Support( a, b, simplex[0].xyz * -1.0f, 0.0f );
+	}
+	if ( count == 2 )
+	{
+		Vec3 u, v;
+		( simplex[1].xyz - simplex[0].xyz ).GetOrtho( u, v );
+		simplex[count++] = Support( a, b, u, 0.0f );
+	}
+	if ( count == 3 )
+	{
+		const Vec3 normal = ( simplex[1].xyz - simplex[0].xyz ).Cross( simplex[2].xyz - simplex[0].xyz );
+		simplex[count++] = Support( a, b, normal, 0.0f );
+	}
+
+	//  expand the simplex by the bias
+	Vec3 center = Vec3( 0.0f );
+	for ( int i = 0; i < 4; i++ )
+	{
+		center += simplex[i].xyz;
+	}
+	center *= 0.25f;
+
+	for ( int i = 0; i < count; i++ )
+	{
+		SupportPoint& point = simplex[i];
+		Vec3 dir = point.xyz - center;
+		dir.Normalize();
+		point.pointA += dir * bias;
+		point.pointB -= dir * bias;
+		point.xyz = point.pointA - point.pointB;
+	}
+
+	EPA_Expand( a, b, bias, simplex, point_a, point_b );
+	return true;
+}
+
+/*
+====================================================
+GJK_ClosestPoints
+====================================================
+*/
+void GJK_ClosestPoints( const ShapePose& a, const ShapePose& b, Vec3& point_a, Vec3& point_b, Vec3* separating_axis )
+{
+	SupportPoint simplex[4];
+	int count = 1;
+	simplex[0] = Support( a, b, GetStartDirection( separating_axis ), 0.0f );
+
+	float closest_distance = 1e10f;
+	Vec4 lambdas = Vec4( 1.0f, 0.0f, 0.0f, 0.0f );
+	Vec3 new_dir = simplex[0].xyz * -1.0f;
+	do
+	{
+		const SupportPoint new_point = Support( a, b, new_dir, 0.0f );
+		if ( HasPoint( simplex, count, new_point ) ) break;
+
+		simplex[count] = new_point;
+		count++;
+
+		SimplexSignedVolumes( simplex, count, new_dir, lambdas );
+		count = SortValids( simplex, lambdas );
+
+		const float distance = new_dir.GetLengthSqr();
+		if ( distance >= closest_distance ) break;
+		closest_distance = distance;
+	} while ( count < 4 );
+
+	if ( separating_axis != nullptr )
+	{
+		*separating_axis = new_dir;
+	}
+
+	point_a = Vec3( 0.0f );
+	point_b = Vec3( 0.0f );
+	for ( int i = 0; i < count; i++ )
+	{
+		point_a += simplex[i].pointA * lambdas[i];
+		point_b += simplex[i].pointB * lambdas[i];
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "Shape.h"
+
+//  shape placed in the world, usually a body extrapolated to some time
+struct ShapePose
+{
+	const Shape* shape;
+	Vec3 position;
+	Quat orientation;
+};
+
+/*
+====================================================
+GJK / EPA
+
+separating_axis is optional: when set, it holds the last
+search direction found for this pair, the search starts from
+it and it's updated with the new one. Between steps, resting
+or slowly moving shapes then converge in a support round or two.
+====================================================
+*/
+bool GJK_DoesIntersect(
+	const ShapePose& a, const ShapePose& b,
+	const float bias,
+	Vec3& point_a, Vec3& point_b,
+	Vec3* separating_axis
+);
+
+void GJK_ClosestPoints(
+	const ShapePose& a, const ShapePose& b,
+	Vec3& point_a, Vec3& point_b,
+	Vec3* separating_axis
+);
@@ -1,51 +1,221 @@
 #include "Intersection.h"
 
-bool Intersection::Intersect( Body& a, Body& b, const float dt, Contact& contact )
+#include "GJK.h"
+#include "Narrowphase.h"
+
+#include <algorithm>
+
+//  max steps of the conservative advancement before giving up on a pair
+const int CONSERVATIVE_ADVANCE_ITERATIONS = 10;
+//  extra distance speculative contacts are kept at, same as the broadphase bounds
+const float SPECULATIVE_MARGIN = 0.01f;
+
+//  indexed by [type_a][type_b], see Shape::ShapeType
+static const Intersection::IntersectFunction s_intersectFunctions[(int) Shape::ShapeType::SHAPE_NUM][(int) Shape::ShapeType::SHAPE_NUM] =
+{
+	//  SHAPE_SPHERE
+	{ Intersection::SphereToSphere, Intersection::ConvexToConvex, Intersection::ConvexToConvex },
+	//  SHAPE_BOX
+	{ Intersection::ConvexToConvex, Intersection::ConvexToConvex, Intersection::ConvexToConvex },
+	//  SHAPE_CONVEX
+	{ Intersection::ConvexToConvex, Intersection::ConvexToConvex, Intersection::ConvexToConvex },
+};
+
+//  same layout, for ContactMode::Speculative
+static const Intersection::IntersectFunction s_speculativeFunctions[(int) Shape::ShapeType::SHAPE_NUM][(int) Shape::ShapeType::SHAPE_NUM] =
+{
+	//  SHAPE_SPHERE
+	{ Intersection::SpeculativeSphereToSphere, Intersection::SpeculativeConvexToConvex, Intersection::SpeculativeConvexToConvex },
+	//  SHAPE_BOX
+	{ Intersection::SpeculativeConvexToConvex, Intersection::SpeculativeConvexToConvex, Intersection::SpeculativeConvexToConvex },
+	//  SHAPE_CONVEX
+	{ Intersection::SpeculativeConvexToConvex, Intersection::SpeculativeConvexToConvex, Intersection::SpeculativeConvexToConvex },
+};
+
+bool Intersection::Intersect( const Body& a, const Body& b, const float dt, Contact& contact )
+{
+	return GetIntersectFunction( a.shape->GetType(), b.shape->GetType() )( a, b, dt, nullptr, contact );
+}
+
+Intersection::IntersectFunction Intersection::GetIntersectFunction( Shape::ShapeType type_a, Shape::ShapeType type_b )
 {
-	contact.bodyA = &a;
-	contact.bodyB = &b;
+	return s_intersectFunctions[(int) type_a][(int) type_b];
+}
+
+Intersection::IntersectFunction Intersection::GetSpeculativeFunction( Shape::ShapeType type_a, Shape::ShapeType type_b )
+{
+	return s_speculativeFunctions[(int) type_a][(int) type_b];
+}
 
+bool Intersection::SphereToSphere( const Body& a, const Body& b, const float dt, PairCache* cache, Contact& contact )
+{
 	const Vec3 ab = b.position - a.position;
 	contact.normal = ab;
 	contact.normal.Normalize();
 
-	if ( a.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE
-	  && b.shape->GetType() == Shape::ShapeType::SHAPE_SPHERE )
+	const ShapeSphere* sphere_a = static_cast<const ShapeSphere*>( a.shape );
+	const ShapeSphere* sphere_b = static_cast<const ShapeSphere*>( b.shape );
+
+	if ( !Intersection::DynamicSphereToSphere( 
+			*sphere_a, *sphere_b, 
+			a.position, b.position, 
+			a.linearVelocity, b.linearVelocity, 
+			dt, 
+			contact.worldContactA, contact.worldContactB, 
+			contact.impactTime 
+		) )
 	{
-		ShapeSphere* sphere_a = reinterpret_cast<ShapeSphere*>( a.shape );
-		ShapeSphere* sphere_b = reinterpret_cast<ShapeSphere*>( b.shape );
-
-		if ( Intersection::DynamicSphereToSphere( 
-				*sphere_a, *sphere_b, 
-				a.position, b.position, 
-				a.linearVelocity, b.linearVelocity, 
-				dt, 
-				contact.worldContactA, contact.worldContactB, 
-				contact.impactTime 
-			) )
-		{
-			a.Update( contact.impactTime );
-			b.Update( contact.impactTime );
-		
-			contact.localContactA = a.WorldToLocal( contact.worldContactA );
-			contact.localContactB = b.WorldToLocal( contact.worldContactB );
+		return false;
+	}
+
+	ComputeLocalContacts( a, b, contact );
 
-			Vec3 ab = a.position - b.position;
-			contact.normal = ab;
-			contact.normal.Normalize();
+	//  sphere centers only move linearly
+	Vec3 impact_ab = ( a.position + a.linearVelocity * contact.impactTime )
+		           - ( b.position + b.linearVelocity * contact.impactTime );
+	contact.normal = impact_ab;
+	contact.normal.Normalize();
 
-			a.Update( -contact.impactTime );
-			b.Update( -contact.impactTime );
+	float r = impact_ab.GetMagnitude() - ( sphere_a->radius + sphere_b->radius );
+	contact.separationDistance = r;
+	return true;
+}
 
-			float r = ab.GetMagnitude() - ( sphere_a->radius + sphere_b->radius );
-			contact.separationDistance = r;
+static ShapePose GetPoseAt( const Body& body, const float dt )
+{
+	ShapePose pose;
+	pose.shape = body.shape;
+	pose.orientation = body.GetOrientationAt( dt );
+	pose.position = body.GetWorldMassCenterAt( dt ) - pose.orientation.RotatePoint( body.GetLocalMassCenter() );
+	return pose;
+}
+
+//  contact between both shapes at their current pose, fills the closest points when separated
+static bool StaticConvexToConvex( const ShapePose& a, const ShapePose& b, Vec3* separating_axis, Contact& contact )
+{
+	const float bias = 0.001f;
+
+	Vec3 point_a, point_b;
+	if ( GJK_DoesIntersect( a, b, bias, point_a, point_b, separating_axis ) )
+	{
+		//  points are penetrating, so this goes from b to a like the spheres normal
+		Vec3 normal = point_b - point_a;
+		normal.Normalize();
+
+		//  remove the bias EPA needed
+		point_a += normal * bias;
+		point_b -= normal * bias;
+
+		contact.worldContactA = point_a;
+		contact.worldContactB = point_b;
+		contact.normal = normal;
+		contact.separationDistance = -( point_a - point_b ).GetMagnitude();
+		return true;
+	}
+
+	GJK_ClosestPoints( a, b, point_a, point_b, separating_axis );
+	contact.worldContactA = point_a;
+	contact.worldContactB = point_b;
+	contact.separationDistance = ( point_b - point_a ).GetMagnitude();
+	return false;
+}
+
+bool Intersection::ConvexToConvex( const Body& a, const Body& b, const float dt, PairCache* cache, Contact& contact )
+{
+	Vec3* separating_axis = cache != nullptr ? &cache->separatingAxis : nullptr;
+
+	//  advance both bodies by the time they need to cover the gap, until they touch
+	float impact_time = 0.0f;
+	float time_left = dt;
+	for ( int i = 0; i < CONSERVATIVE_ADVANCE_ITERATIONS; i++ )
+	{
+		const ShapePose pose_a = GetPoseAt( a, impact_time );
+		const ShapePose pose_b = GetPoseAt( b, impact_time );
+		if ( StaticConvexToConvex( pose_a, pose_b, separating_axis, contact ) )
+		{
+			contact.impactTime = impact_time;
+			ComputeLocalContacts( a, b, contact );
 			return true;
 		}
+
+		Vec3 ab = contact.worldContactB - contact.worldContactA;
+		ab.Normalize();
+
+		//  fastest approach speed, including rotations
+		float ortho_speed = ( a.linearVelocity - b.linearVelocity ).Dot( ab );
+		ortho_speed += a.shape->FastestLinearSpeed( a.angularVelocity, ab );
+		ortho_speed += b.shape->FastestLinearSpeed( b.angularVelocity, ab * -1.0f );
+		if ( ortho_speed <= 0.0f ) break;
+
+		const float time_to_go = contact.separationDistance / ortho_speed;
+		if ( time_to_go > time_left ) break;
+
+		time_left -= time_to_go;
+		impact_time += time_to_go;
 	}
 
 	return false;
 }
 
+//  keep the pair if it may close the gap within dt
+static bool IsSpeculativeContact( const float approach_speed, const float dt, Contact& contact )
+{
+	const float reach = std::max( approach_speed, 0.0f ) * dt + SPECULATIVE_MARGIN;
+	if ( contact.separationDistance > reach ) return false;
+
+	contact.impactTime = 0.0f;
+	contact.isSpeculative = true;
+	return true;
+}
+
+bool Intersection::SpeculativeSphereToSphere( const Body& a, const Body& b, const float dt, PairCache* cache, Contact& contact )
+{
+	const ShapeSphere* sphere_a = static_cast<const ShapeSphere*>( a.shape );
+	const ShapeSphere* sphere_b = static_cast<const ShapeSphere*>( b.shape );
+
+	const Vec3 ba = a.position - b.position;
+	contact.normal = ba;
+	contact.normal.Normalize();
+	contact.separationDistance = ba.GetMagnitude() - ( sphere_a->radius + sphere_b->radius );
+
+	const float approach_speed = ( b.linearVelocity - a.linearVelocity ).Dot( contact.normal );
+	if ( !IsSpeculativeContact( approach_speed, dt, contact ) ) return false;
+
+	contact.worldContactA = a.position - contact.normal * sphere_a->radius;
+	contact.worldContactB = b.position + contact.normal * sphere_b->radius;
+	ComputeLocalContacts( a, b, contact );
+	return true;
+}
+
+bool Intersection::SpeculativeConvexToConvex( const Body& a, const Body& b, const float dt, PairCache* cache, Contact& contact )
+{
+	Vec3* separating_axis = cache != nullptr ? &cache->separatingAxis : nullptr;
+
+	const ShapePose pose_a = GetPoseAt( a, 0.0f );
+	const ShapePose pose_b = GetPoseAt( b, 0.0f );
+	if ( !StaticConvexToConvex( pose_a, pose_b, separating_axis, contact ) )
+	{
+		contact.normal = contact.worldContactA - contact.worldContactB;
+		contact.normal.Normalize();
+	}
+
+	//  fastest approach speed, including rotations
+	const Vec3 ab = contact.normal * -1.0f;
+	float approach_speed = ( a.linearVelocity - b.linearVelocity ).Dot( ab );
+	approach_speed += a.shape->FastestLinearSpeed( a.angularVelocity, ab );
+	approach_speed += b.shape->FastestLinearSpeed( b.angularVelocity, contact.normal );
+	if ( !IsSpeculativeContact( approach_speed, dt, contact ) ) return false;
+
+	ComputeLocalContacts( a, b, contact );
+	return true;
+}
+
+void Intersection::ComputeLocalContacts( const Body& a, const Body& b, Contact& contact )
+{
+	contact.localContactA = a.WorldToLocalAt( contact.worldContactA, contact.impactTime );
+	contact.localContactB = b.WorldToLocalAt( contact.worldContactB, contact.impactTime );
+}
+
 bool Intersection::RaySphere( 
 	const Vec3& origin, 
 	const Vec3& dir, 
@@ -3,10 +3,28 @@
 #include "Shape.h"
 #include "Contact.h"
 
+struct PairCache;
+
 class Intersection
 {
 public:
-	static bool Intersect( Body& a, Body& b, const float dt, Contact& contact );
+	//  cache is optional, it keeps data of the pair from one step to the next
+	typedef bool ( *IntersectFunction )( const Body& a, const Body& b, const float dt, PairCache* cache, Contact& contact );
+
+	//  bodies are left untouched, the caller is in charge of the contact bodies
+	static bool Intersect( const Body& a, const Body& b, const float dt, Contact& contact );
+	//  test function of a shapes pair, from a table indexed by both types
+	static IntersectFunction GetIntersectFunction( Shape::ShapeType type_a, Shape::ShapeType type_b );
+	//  same for ContactMode::Speculative: contacts at the current positions, kept while the gap may close within dt
+	static IntersectFunction GetSpeculativeFunction( Shape::ShapeType type_a, Shape::ShapeType type_b );
+
+	static bool SphereToSphere( const Body& a, const Body& b, const float dt, PairCache* cache, Contact& contact );
+	//  conservative advancement over GJK / EPA, for any pair with a convex shape
+	static bool ConvexToConvex( const Body& a, const Body& b, const float dt, PairCache* cache, Contact& contact );
+	static bool SpeculativeSphereToSphere( const Body& a, const Body& b, const float dt, PairCache* cache, Contact& contact );
+	static bool SpeculativeConvexToConvex( const Body& a, const Body& b, const float dt, PairCache* cache, Contact& contact );
+	//  fill the local contacts from the world ones, at impact time
+	static void ComputeLocalContacts( const Body& a, const Body& b, Contact& contact );
 	
 	static bool RaySphere( 
 		const Vec3& origin, const Vec3& dir, 
@@ -0,0 +1,183 @@
+#include "Island.h"
+
+#include <algorithm>
+
+/*
+====================================================
+Island::Solve
+====================================================
+*/
+void Island::Solve( std::vector<Body>& world_bodies, const float dt, const ContactMode mode, JobSystem& job_system )
+{
+	switch ( mode )
+	{
+		case ContactMode::TimeOfImpact:
+			SolveTimeOfImpact( world_bodies, dt, job_system );
+			break;
+		case ContactMode::Speculative:
+			SolveSpeculative( world_bodies, dt, job_system );
+			break;
+	}
+}
+
+/*
+====================================================
+Island::SolveTimeOfImpact
+====================================================
+*/
+void Island::SolveTimeOfImpact( std::vector<Body>& world_bodies, const float dt, JobSystem& job_system )
+{
+	std::sort( contacts.begin(), contacts.end(), Contact::Compare );
+
+	//  step the island from one impact to the next
+	float accumulated_time = 0.0f;
+	const int count = (int) contacts.size();
+	int i = 0;
+	while ( i < count )
+	{
+		//  contacts happening at the same time, mostly resting ones at 0
+		const int begin = i;
+		do
+		{
+			i++;
+		} while ( i < count && contacts[i].impactTime == contacts[begin].impactTime );
+
+		const float local_dt = contacts[begin].impactTime - accumulated_time;
+
+		//  position
+		for ( int id : bodies )
+		{
+			world_bodies[id].Update( local_dt );
+		}
+
+		if ( i - begin >= CONTACT_BATCH_MIN_CONTACTS )
+		{
+			contactBatches.Build( &contacts[begin], i - begin, world_bodies );
+			contactBatches.Solve( dt, job_system );
+		}
+		else
+		{
+			for ( int j = begin; j < i; j++ )
+			{
+				contacts[j].Resolve();
+			}
+		}
+
+		accumulated_time += local_dt;
+	}
+
+	//  update position depending on remaining time
+	const float time_remaining = dt - accumulated_time;
+	if ( time_remaining > 0.0f )
+	{
+		for ( int id : bodies )
+		{
+			world_bodies[id].Update( time_remaining );
+		}
+	}
+}
+
+/*
+====================================================
+Island::SolveSpeculative
+
+Every contact comes from the current positions, so they
+are all solved at once before moving the bodies by the
+whole step: no sorting and no sub-stepping.
+====================================================
+*/
+void Island::SolveSpeculative( std::vector<Body>& world_bodies, const float dt, JobSystem& job_system )
+{
+	const int count = (int) contacts.size();
+	if ( count >= CONTACT_BATCH_MIN_CONTACTS )
+	{
+		contactBatches.Build( contacts.data(), count, world_bodies );
+		contactBatches.Solve( dt, job_system );
+	}
+	else
+	{
+		for ( Contact& contact : contacts )
+		{
+			contact.ResolveSpeculative( dt );
+		}
+	}
+
+	for ( int id : bodies )
+	{
+		world_bodies[id].Update( dt );
+	}
+}
+
+/*
+====================================================
+FindRoot
+====================================================
+*/
+static int FindRoot( std::vector<int>& parents, int id )
+{
+	while ( parents[id] != id )
+	{
+		//  path halving
+		parents[id] = parents[parents[id]];
+		id = parents[id];
+	}
+	return id;
+}
+
+/*
+====================================================
+BuildIslands
+====================================================
+*/
+void BuildIslands(
+	const std::vector<Body>& bodies,
+	const std::vector<Contact>& contacts,
+	std::vector<Island>& islands
+)
+{
+	islands.clear();
+
+	const int count = (int) bodies.size();
+	std::vector<int> parents( count );
+	for ( int i = 0; i < count; i++ )
+	{
+		parents[i] = i;
+	}
+
+	//  merge dynamic bodies touching each other, static ones would glue the whole world
+	for ( const Contact& contact : contacts )
+	{
+		if ( contact.bodyA->IsStatic() || contact.bodyB->IsStatic() ) continue;
+
+		const int root_a = FindRoot( parents, (int) ( contact.bodyA - bodies.data() ) );
+		const int root_b = FindRoot( parents, (int) ( contact.bodyB - bodies.data() ) );
+		if ( root_a == root_b ) continue;
+
+		//  keep the lowest id as root so the islands order only depends on the bodies order
+		parents[std::max( root_a, root_b )] = std::min( root_a, root_b );
+	}
+
+	//  every dynamic body belongs to an island, even alone
+	std::vector<int> island_ids( count, -1 );
+	for ( int i = 0; i < count; i++ )
+	{
+		if ( bodies[i].IsStatic() ) continue;
+
+		const int root = FindRoot( parents, i );
+		if ( island_ids[root] < 0 )
+		{
+			island_ids[root] = (int) islands.size();
+			islands.emplace_back();
+		}
+
+		islands[island_ids[root]].bodies.push_back( i );
+	}
+
+	for ( const Contact& contact : contacts )
+	{
+		const Body* dynamic_body = contact.bodyA->IsStatic() ? contact.bodyB : contact.bodyA;
+		const int root = FindRoot( parents, (int) ( dynamic_body - bodies.data() ) );
+
+		islands[island_ids[root]].contacts.push_back( contact );
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+
+#include "Body.h"
+#include "Contact.h"
+#include "ContactBatch.h"
+#include "JobSystem.h"
+
+/*
+====================================================
+Island
+
+Group of dynamic bodies linked together by contacts.
+Static bodies never join an island, so two islands never
+write to the same body and can be solved concurrently.
+====================================================
+*/
+class Island
+{
+public:
+	std::vector<int> bodies;
+	std::vector<Contact> contacts;
+
+	int GetWorkSize() const { return (int) ( bodies.size() + contacts.size() ); }
+
+	//  job_system splits big groups of simultaneous contacts across threads
+	void Solve( std::vector<Body>& world_bodies, const float dt, const ContactMode mode, JobSystem& job_system );
+
+	static bool CompareWorkSize( const Island& a, const Island& b )
+	{
+		return a.GetWorkSize() > b.GetWorkSize();
+	}
+
+private:
+	ContactBatches contactBatches;
+
+	void SolveTimeOfImpact( std::vector<Body>& world_bodies, const float dt, JobSystem& job_system );
+	void SolveSpeculative( std::vector<Body>& world_bodies, const float dt, JobSystem& job_system );
+};
+
+void BuildIslands(
+	const std::vector<Body>& bodies,
+	const std::vector<Contact>& contacts,
+	std::vector<Island>& islands
+);
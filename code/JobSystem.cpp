@@ -0,0 +1,253 @@
+//
+//  JobSystem.cpp
+//
+#include "JobSystem.h"
+
+#include <algorithm>
+
+//  queue owned by the current thread, -1 for threads outside of the pool
+static thread_local int g_workerId = -1;
+
+/*
+====================================================
+JobSystem::JobSystem
+====================================================
+*/
+JobSystem::JobSystem( int workers_count )
+{
+	if ( workers_count <= 0 )
+	{
+		const int hardware_threads = (int) std::thread::hardware_concurrency();
+		workers_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+	}
+
+	//  one queue per worker plus one shared by outside threads
+	for ( int i = 0; i < workers_count + 1; i++ )
+	{
+		queues.push_back( new WorkerQueue() );
+	}
+
+	workers.reserve( workers_count );
+	for ( int i = 0; i < workers_count; i++ )
+	{
+		workers.emplace_back( &JobSystem::WorkerLoop, this, i );
+	}
+}
+
+/*
+====================================================
+JobSystem::~JobSystem
+====================================================
+*/
+JobSystem::~JobSystem()
+{
+	Wait();
+
+	{
+		std::lock_guard<std::mutex> lock( sleepMutex );
+		isRunning = false;
+	}
+	sleepCondition.notify_all();
+
+	for ( std::thread& worker : workers )
+	{
+		worker.join();
+	}
+
+	for ( WorkerQueue* queue : queues )
+	{
+		delete queue;
+	}
+}
+
+/*
+====================================================
+JobSystem::Submit
+====================================================
+*/
+void JobSystem::Submit( Job job, JobCounter* counter )
+{
+	//  workers keep their own jobs, others spread them across the pool
+	int queue_id = g_workerId;
+	if ( queue_id < 0 )
+	{
+		queue_id = nextQueue.fetch_add( 1 ) % (int) queues.size();
+	}
+
+	pendingJobs++;
+	if ( counter != nullptr )
+	{
+		( *counter )++;
+	}
+
+	{
+		WorkerQueue& queue = *queues[queue_id];
+		std::lock_guard<std::mutex> lock( queue.mutex );
+		queue.jobs.push_back( { std::move( job ), counter } );
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( sleepMutex );
+		queuedJobs++;
+	}
+	sleepCondition.notify_one();
+}
+
+/*
+====================================================
+JobSystem::Wait
+====================================================
+*/
+void JobSystem::Wait()
+{
+	const int queue_id = GetCurrentQueue();
+	while ( pendingJobs > 0 )
+	{
+		if ( RunNextJob( queue_id ) ) continue;
+
+		//  remaining jobs are running on other threads
+		std::this_thread::yield();
+	}
+}
+
+/*
+====================================================
+JobSystem::Wait
+====================================================
+*/
+void JobSystem::Wait( const JobCounter& counter )
+{
+	//  helping with unrelated jobs is fine, waiting on pendingJobs is not
+	//  since it would count the job calling us
+	const int queue_id = GetCurrentQueue();
+	while ( counter > 0 )
+	{
+		if ( RunNextJob( queue_id ) ) continue;
+
+		std::this_thread::yield();
+	}
+}
+
+/*
+====================================================
+JobSystem::ParallelFor
+====================================================
+*/
+void JobSystem::ParallelFor( int count, int batch_size, const std::function<void( int begin, int end )>& func )
+{
+	if ( count <= 0 ) return;
+	if ( batch_size < 1 ) batch_size = 1;
+
+	//  the calling thread keeps the first range for itself
+	JobCounter counter { 0 };
+	for ( int begin = batch_size; begin < count; begin += batch_size )
+	{
+		const int end = std::min( begin + batch_size, count );
+		Submit( [&func, begin, end] { func( begin, end ); }, &counter );
+	}
+
+	func( 0, std::min( batch_size, count ) );
+	Wait( counter );
+}
+
+/*
+====================================================
+JobSystem::WorkerLoop
+====================================================
+*/
+void JobSystem::WorkerLoop( int worker_id )
+{
+	g_workerId = worker_id;
+
+	while ( true )
+	{
+		if ( RunNextJob( worker_id ) ) continue;
+
+		std::unique_lock<std::mutex> lock( sleepMutex );
+		sleepCondition.wait( lock, [this] { return queuedJobs > 0 || !isRunning; } );
+		if ( !isRunning ) break;
+	}
+}
+
+/*
+====================================================
+JobSystem::PopJob
+====================================================
+*/
+bool JobSystem::PopJob( int queue_id, QueuedJob& job )
+{
+	WorkerQueue& queue = *queues[queue_id];
+	std::lock_guard<std::mutex> lock( queue.mutex );
+	if ( queue.jobs.empty() ) return false;
+
+	//  newest first, its data is likely still in cache
+	job = std::move( queue.jobs.back() );
+	queue.jobs.pop_back();
+	queuedJobs--;
+	return true;
+}
+
+/*
+====================================================
+JobSystem::StealJob
+====================================================
+*/
+bool JobSystem::StealJob( int thief_id, QueuedJob& job )
+{
+	const int count = (int) queues.size();
+	for ( int i = 1; i < count; i++ )
+	{
+		WorkerQueue& queue = *queues[( thief_id + i ) % count];
+		std::lock_guard<std::mutex> lock( queue.mutex );
+		if ( queue.jobs.empty() ) continue;
+
+		//  oldest first, leave the owner its hot jobs
+		job = std::move( queue.jobs.front() );
+		queue.jobs.pop_front();
+		queuedJobs--;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+====================================================
+JobSystem::RunNextJob
+====================================================
+*/
+bool JobSystem::RunNextJob( int queue_id )
+{
+	QueuedJob job;
+	if ( !PopJob( queue_id, job ) && !StealJob( queue_id, job ) ) return false;
+
+	RunJob( job );
+	return true;
+}
+
+/*
+====================================================
+JobSystem::RunJob
+====================================================
+*/
+void JobSystem::RunJob( QueuedJob& job )
+{
+	job.job();
+	job.job = nullptr;
+
+	if ( job.counter != nullptr )
+	{
+		( *job.counter )--;
+	}
+	pendingJobs--;
+}
+
+/*
+====================================================
+JobSystem::GetCurrentQueue
+====================================================
+*/
+int JobSystem::GetCurrentQueue() const
+{
+	return g_workerId < 0 ? (int) queues.size() - 1 : g_workerId;
+}
@@ -0,0 +1,75 @@
+//
+//  JobSystem.h
+//
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+====================================================
+JobSystem
+
+Pool of worker threads, each owning a queue of jobs.
+A worker pops its own jobs from the back and steals from
+the front of the other queues once its own is empty.
+====================================================
+*/
+class JobSystem
+{
+public:
+	typedef std::function<void()> Job;
+	typedef std::atomic<int> JobCounter;
+
+	//  0 workers means one per hardware thread, minus the calling thread
+	JobSystem( int workers_count = 0 );
+	~JobSystem();
+
+	//  the optional counter is incremented now and decremented once the job is done
+	void Submit( Job job, JobCounter* counter = nullptr );
+
+	//  block until every submitted job is done, the calling thread helps meanwhile
+	void Wait();
+	//  block until the counter jobs are done, safe to call from inside a job
+	void Wait( const JobCounter& counter );
+
+	//  split [0; count[ into ranges of batch_size elements, processed concurrently
+	void ParallelFor( int count, int batch_size, const std::function<void( int begin, int end )>& func );
+
+	int GetWorkersCount() const { return (int) workers.size(); }
+
+private:
+	struct QueuedJob
+	{
+		Job job;
+		JobCounter* counter;
+	};
+
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<QueuedJob> jobs;
+	};
+
+	void WorkerLoop( int worker_id );
+	bool PopJob( int queue_id, QueuedJob& job );
+	bool StealJob( int thief_id, QueuedJob& job );
+	bool RunNextJob( int queue_id );
+	void RunJob( QueuedJob& job );
+	int GetCurrentQueue() const;
+
+	std::vector<std::thread> workers;
+	std::vector<WorkerQueue*> queues;	//  one per worker, the last one belongs to the calling threads
+
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+
+	std::atomic<int> queuedJobs { 0 };		//  jobs waiting in a queue
+	std::atomic<int> pendingJobs { 0 };		//  jobs not finished yet
+	std::atomic<int> nextQueue { 0 };
+	std::atomic<bool> isRunning { true };
+};
@@ -0,0 +1,188 @@
+#include "Manifold.h"
+
+//  max distance between two contacts in local space to be seen as the same point
+const float MANIFOLD_MATCH_DISTANCE = 0.02f;
+//  max drift of a point, along the normal or across it, before it's dropped
+const float MANIFOLD_BREAKING_DISTANCE = 0.02f;
+
+float Manifold::GetSeparation( const Body& a, const Body& b, const ManifoldPoint& point ) const
+{
+	const Vec3 point_a = a.LocalToWorld( point.localContactA );
+	const Vec3 point_b = b.LocalToWorld( point.localContactB );
+	return ( point_a - point_b ).Dot( normal );
+}
+
+void Manifold::RemoveExpiredPoints( const Body& a, const Body& b )
+{
+	for ( int i = 0; i < count; i++ )
+	{
+		const Vec3 point_a = a.LocalToWorld( points[i].localContactA );
+		const Vec3 point_b = b.LocalToWorld( points[i].localContactB );
+		const Vec3 ab = point_a - point_b;
+
+		const float separation = ab.Dot( normal );
+		const Vec3 drift = ab - normal * separation;
+		if ( separation <= MANIFOLD_BREAKING_DISTANCE
+		  && drift.GetLengthSqr() <= MANIFOLD_BREAKING_DISTANCE * MANIFOLD_BREAKING_DISTANCE ) continue;
+
+		//  order doesn't matter, fill the hole with the last point
+		points[i] = points[count - 1];
+		count--;
+		i--;
+	}
+}
+
+void Manifold::AddContact( Contact& contact )
+{
+	normal = contact.normal;
+
+	ManifoldPoint new_point;
+	new_point.localContactA = contact.localContactA;
+	new_point.localContactB = contact.localContactB;
+
+	//  same point as a previous step, keep its impulses
+	for ( int i = 0; i < count; i++ )
+	{
+		ManifoldPoint& point = points[i];
+		if ( ( point.localContactA - new_point.localContactA ).GetLengthSqr() > MANIFOLD_MATCH_DISTANCE * MANIFOLD_MATCH_DISTANCE ) continue;
+		if ( ( point.localContactB - new_point.localContactB ).GetLengthSqr() > MANIFOLD_MATCH_DISTANCE * MANIFOLD_MATCH_DISTANCE ) continue;
+
+		point.localContactA = new_point.localContactA;
+		point.localContactB = new_point.localContactB;
+		contact.manifoldPoint = &point;
+		return;
+	}
+
+	if ( count < MAX_POINTS )
+	{
+		points[count] = new_point;
+		contact.manifoldPoint = &points[count];
+		count++;
+		return;
+	}
+
+	ReducePoints( *contact.bodyA, *contact.bodyB, new_point );
+
+	//  the new point may not be part of the kept set
+	contact.manifoldPoint = nullptr;
+	for ( int i = 0; i < count; i++ )
+	{
+		if ( points[i].localContactA == new_point.localContactA && points[i].localContactB == new_point.localContactB )
+		{
+			contact.manifoldPoint = &points[i];
+			break;
+		}
+	}
+}
+
+void Manifold::ReducePoints( const Body& a, const Body& b, const ManifoldPoint& new_point )
+{
+	ManifoldPoint candidates[MAX_POINTS + 1];
+	Vec3 positions[MAX_POINTS + 1];
+	bool is_kept[MAX_POINTS + 1] = {};
+	for ( int i = 0; i < MAX_POINTS; i++ )
+	{
+		candidates[i] = points[i];
+	}
+	candidates[MAX_POINTS] = new_point;
+
+	const int candidates_count = MAX_POINTS + 1;
+	for ( int i = 0; i < candidates_count; i++ )
+	{
+		positions[i] = a.LocalToWorld( candidates[i].localContactA );
+	}
+
+	//  deepest point first
+	int kept[MAX_POINTS];
+	kept[0] = 0;
+	float min_separation = GetSeparation( a, b, candidates[0] );
+	for ( int i = 1; i < candidates_count; i++ )
+	{
+		const float separation = GetSeparation( a, b, candidates[i] );
+		if ( separation < min_separation )
+		{
+			min_separation = separation;
+			kept[0] = i;
+		}
+	}
+	is_kept[kept[0]] = true;
+
+	//  then the furthest from it, the biggest triangle and the biggest quad
+	for ( int k = 1; k < MAX_POINTS; k++ )
+	{
+		float max_score = -1.0f;
+		kept[k] = -1;
+		for ( int i = 0; i < candidates_count; i++ )
+		{
+			if ( is_kept[i] ) continue;
+
+			const Vec3& p = positions[i];
+			float score = 0.0f;
+			if ( k == 1 )
+			{
+				score = ( p - positions[kept[0]] ).GetLengthSqr();
+			}
+			else if ( k == 2 )
+			{
+				score = ( positions[kept[1]] - positions[kept[0]] ).Cross( p - positions[kept[0]] ).GetLengthSqr();
+			}
+			else
+			{
+				for ( int e = 0; e < 3; e++ )
+				{
+					const Vec3& edge_a = positions[kept[e]];
+					const Vec3& edge_b = positions[kept[( e + 1 ) % 3]];
+					score += ( edge_b - edge_a ).Cross( p - edge_a ).GetMagnitude();
+				}
+			}
+
+			if ( score > max_score )
+			{
+				max_score = score;
+				kept[k] = i;
+			}
+		}
+		is_kept[kept[k]] = true;
+	}
+
+	for ( int i = 0; i < MAX_POINTS; i++ )
+	{
+		points[i] = candidates[kept[i]];
+	}
+	count = MAX_POINTS;
+}
+
+void Manifold::GetPersistentContacts( Body& a, Body& b, const Contact& contact, std::vector<Contact>& contacts )
+{
+	for ( int i = 0; i < count; i++ )
+	{
+		ManifoldPoint& point = points[i];
+		if ( &point == contact.manifoldPoint ) continue;
+
+		//  separated points don't need any impulse
+		const float separation = GetSeparation( a, b, point );
+		if ( separation > 0.0f ) continue;
+
+		//  neither do points moving apart, the solver could only pull them back together
+		const Vec3 world_contact_a = a.LocalToWorld( point.localContactA );
+		const Vec3 world_contact_b = b.LocalToWorld( point.localContactB );
+		const Vec3 velocity_a = a.linearVelocity + a.angularVelocity.Cross( world_contact_a - a.GetWorldMassCenter() );
+		const Vec3 velocity_b = b.linearVelocity + b.angularVelocity.Cross( world_contact_b - b.GetWorldMassCenter() );
+		if ( ( velocity_a - velocity_b ).Dot( normal ) >= 0.0f ) continue;
+
+		Contact persistent_contact;
+		persistent_contact.bodyA = &a;
+		persistent_contact.bodyB = &b;
+		persistent_contact.localContactA = point.localContactA;
+		persistent_contact.localContactB = point.localContactB;
+		persistent_contact.worldContactA = world_contact_a;
+		persistent_contact.worldContactB = world_contact_b;
+		persistent_contact.normal = normal;
+		persistent_contact.separationDistance = separation;
+		persistent_contact.impactTime = contact.impactTime;
+		persistent_contact.isPersistent = true;
+		persistent_contact.isSpeculative = contact.isSpeculative;
+		persistent_contact.manifoldPoint = &point;
+		contacts.push_back( persistent_contact );
+	}
+}
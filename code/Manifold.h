@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+
+#include "Body.h"
+#include "Contact.h"
+
+class ManifoldPoint
+{
+public:
+	Vec3 localContactA;
+	Vec3 localContactB;
+
+	//  impulses applied during the last resolution, the base for warm starting
+	float normalImpulse = 0.0f;
+	Vec3 tangentImpulse;	//  friction applied to b in world space, a got the opposite
+};
+
+/*
+====================================================
+Manifold
+
+Contact points of a persistent pair, kept across steps.
+New contacts replace the point they are close to in local
+space, keeping its cached impulses. Past MAX_POINTS, the
+deepest point and the widest set around it are kept.
+====================================================
+*/
+class Manifold
+{
+public:
+	static const int MAX_POINTS = 4;
+
+	ManifoldPoint points[MAX_POINTS];
+	int count = 0;
+	Vec3 normal;	//  from b to a, as in Contact
+
+	void Clear() { count = 0; }
+
+	//  drop points the bodies moved away from since they were added
+	void RemoveExpiredPoints( const Body& a, const Body& b );
+	//  match or insert the contact, then link it to its point
+	void AddContact( Contact& contact );
+	//  resting contacts of the other points still approaching, meant for a pair touching at impact time 0
+	void GetPersistentContacts( Body& a, Body& b, const Contact& contact, std::vector<Contact>& contacts );
+
+private:
+	float GetSeparation( const Body& a, const Body& b, const ManifoldPoint& point ) const;
+	void ReducePoints( const Body& a, const Body& b, const ManifoldPoint& new_point );
+};
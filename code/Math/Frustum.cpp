@@ -0,0 +1,90 @@
+//
+//	Frustum.cpp
+//
+#include "Frustum.h"
+#include "Simd.h"
+#include <algorithm>
+
+/*
+====================================================
+Frustum::SetFromMatrix
+====================================================
+*/
+void Frustum::SetFromMatrix( const Mat4 & viewProj ) {
+	const Vec4 & x = viewProj.rows[ 0 ];
+	const Vec4 & y = viewProj.rows[ 1 ];
+	const Vec4 & z = viewProj.rows[ 2 ];
+	const Vec4 & w = viewProj.rows[ 3 ];
+
+	// Clip space is -w <= x,y <= w and 0 <= z <= w
+	planes[ 0 ] = w + x;
+	planes[ 1 ] = w - x;
+	planes[ 2 ] = w + y;
+	planes[ 3 ] = w - y;
+	planes[ 4 ] = z;
+	planes[ 5 ] = w - z;
+
+	// Unit normals, so the plane distance can be compared to a radius
+	for ( int i = 0; i < 6; i++ ) {
+		const float length = Vec3( planes[ i ].x, planes[ i ].y, planes[ i ].z ).GetMagnitude();
+		planes[ i ] = planes[ i ] * ( 1.0f / length );
+	}
+}
+
+/*
+====================================================
+Frustum::IsSphereVisible
+====================================================
+*/
+bool Frustum::IsSphereVisible( const Vec3 & center, const float radius ) const {
+	for ( int i = 0; i < 6; i++ ) {
+		const Vec4 & plane = planes[ i ];
+		const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		if ( distance < -radius ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+====================================================
+Frustum::CullSpheres
+====================================================
+*/
+int Frustum::CullSpheres( const Vec3 * centers, const float * radii, unsigned char * visible, const int num ) const {
+	float xs[ SIMD_WIDTH ];
+	float ys[ SIMD_WIDTH ];
+	float zs[ SIMD_WIDTH ];
+	float rs[ SIMD_WIDTH ];
+
+	int numVisible = 0;
+	for ( int start = 0; start < num; start += SIMD_WIDTH ) {
+		const int count = std::min( SIMD_WIDTH, num - start );
+		for ( int i = 0; i < SIMD_WIDTH; i++ ) {
+			const Vec3 center = ( i < count ) ? centers[ start + i ] : Vec3( 0.0f );
+			xs[ i ] = center.x;
+			ys[ i ] = center.y;
+			zs[ i ] = center.z;
+			rs[ i ] = ( i < count ) ? radii[ start + i ] : 0.0f;
+		}
+
+		const SimdVec3 center = SimdVec3::Load( xs, ys, zs );
+		const SimdFloat negRadius = SimdFloat::Broadcast( 0.0f ) - SimdFloat::Load( rs );
+
+		// A lane is culled as soon as it's fully behind one of the planes
+		SimdFloat outside = SimdFloat::Broadcast( 0.0f );	// all bits clear, nothing culled yet
+		for ( int p = 0; p < 6; p++ ) {
+			const SimdVec3 normal( SimdFloat::Broadcast( planes[ p ].x ), SimdFloat::Broadcast( planes[ p ].y ), SimdFloat::Broadcast( planes[ p ].z ) );
+			const SimdFloat distance = center.Dot( normal ) + SimdFloat::Broadcast( planes[ p ].w );
+			outside = outside | distance.Less( negRadius );
+		}
+
+		const int outsideMask = outside.GetMask();
+		for ( int i = 0; i < count; i++ ) {
+			visible[ start + i ] = ( outsideMask & ( 1 << i ) ) ? 0 : 1;
+			numVisible += visible[ start + i ];
+		}
+	}
+	return numVisible;
+}
@@ -0,0 +1,31 @@
+//
+//	Frustum.h
+//
+#pragma once
+#include "Vector.h"
+#include "Matrix.h"
+
+/*
+====================================================
+Frustum
+
+The 6 planes of a view volume, pulled out of the
+projection * view matrix. Normals point inside, a
+point is inside when Dot( normal, p ) + w >= 0 for
+every plane. Works for both perspective and ortho.
+====================================================
+*/
+class Frustum {
+public:
+	// viewProj is proj * view before the transpose for the shaders, in Vulkan clip space
+	void SetFromMatrix( const Mat4 & viewProj );
+
+	bool IsSphereVisible( const Vec3 & center, const float radius ) const;
+
+	// visible[ i ] = 1 when the sphere touches the frustum, 0 otherwise,
+	// SIMD_WIDTH spheres at a time. Returns the number of visible spheres.
+	int CullSpheres( const Vec3 * centers, const float * radii, unsigned char * visible, const int num ) const;
+
+public:
+	Vec4 planes[ 6 ];	// xyz normal, w distance
+};
@@ -151,6 +151,32 @@ inline float Mat3::Trace() const {
 	return ( xx + yy + zz );
 }
 
+#if defined( MATH_SIMD )
+inline float Mat3::Determinant() const {
+	return rows[ 0 ].Dot( rows[ 1 ].Cross( rows[ 2 ] ) );
+}
+
+inline Mat3 Mat3::Transpose() const {
+	__m128 row0 = rows[ 0 ].GetSimd();
+	__m128 row1 = rows[ 1 ].GetSimd();
+	__m128 row2 = rows[ 2 ].GetSimd();
+	__m128 row3 = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS( row0, row1, row2, row3 );
+	return Mat3( Vec3( row0 ), Vec3( row1 ), Vec3( row2 ) );
+}
+
+inline Mat3 Mat3::Inverse() const {
+	// closed form: the columns of the inverse are the cross products of the rows, over the determinant
+	const Vec3 col0 = rows[ 1 ].Cross( rows[ 2 ] );
+	const Vec3 col1 = rows[ 2 ].Cross( rows[ 0 ] );
+	const Vec3 col2 = rows[ 0 ].Cross( rows[ 1 ] );
+	float det = rows[ 0 ].Dot( col0 );
+	float invDet = 1.0f / det;
+	Mat3 inv = Mat3( col0, col1, col2 ).Transpose();
+	inv *= invDet;
+	return inv;
+}
+#else
 inline float Mat3::Determinant() const {
 	const float i = rows[ 0 ][ 0 ] * ( rows[ 1 ][ 1 ] * rows[ 2 ][ 2 ] - rows[ 1 ][ 2 ] * rows[ 2 ][ 1 ] );
 	const float j = rows[ 0 ][ 1 ] * ( rows[ 1 ][ 0 ] * rows[ 2 ][ 2 ] - rows[ 1 ][ 2 ] * rows[ 2 ][ 0 ] );
@@ -181,6 +207,8 @@ inline Mat3 Mat3::Inverse() const {
 	return inv;
 }
 
+#endif
+
 inline Mat2 Mat3::Minor( const int i, const int j ) const {
 	Mat2 minor;
 
@@ -211,6 +239,16 @@ inline float Mat3::Cofactor( const int i, const int j ) const {
 	return C;
 }
 
+#if defined( MATH_SIMD )
+inline Vec3 Mat3::operator * ( const Vec3 & rhs ) const {
+	// each dot product lands in its own lane
+	const __m128 v = rhs.GetSimd();
+	const __m128 x = _mm_dp_ps( rows[ 0 ].GetSimd(), v, 0x71 );
+	const __m128 y = _mm_dp_ps( rows[ 1 ].GetSimd(), v, 0x72 );
+	const __m128 z = _mm_dp_ps( rows[ 2 ].GetSimd(), v, 0x74 );
+	return Vec3( _mm_or_ps( _mm_or_ps( x, y ), z ) );
+}
+#else
 inline Vec3 Mat3::operator * ( const Vec3 & rhs ) const {
 	Vec3 tmp;
 	tmp[ 0 ] = rows[ 0 ].Dot( rhs );
@@ -219,6 +257,8 @@ inline Vec3 Mat3::operator * ( const Vec3 & rhs ) const {
 	return tmp;
 }
 
+#endif
+
 inline Mat3 Mat3::operator * ( const float rhs ) const {
 	Mat3 tmp;
 	tmp.rows[ 0 ] = rows[ 0 ] * rhs;
@@ -227,6 +267,23 @@ inline Mat3 Mat3::operator * ( const float rhs ) const {
 	return tmp;
 }
 
+#if defined( MATH_SIMD )
+inline Mat3 Mat3::operator * ( const Mat3 & rhs ) const {
+	const __m128 rhs0 = rhs.rows[ 0 ].GetSimd();
+	const __m128 rhs1 = rhs.rows[ 1 ].GetSimd();
+	const __m128 rhs2 = rhs.rows[ 2 ].GetSimd();
+
+	Mat3 tmp;
+	for ( int i = 0; i < 3; i++ ) {
+		const __m128 row = rows[ i ].GetSimd();
+		__m128 result = _mm_mul_ps( SimdMath::Splat< 0 >( row ), rhs0 );
+		result = SimdMath::MulAdd( SimdMath::Splat< 1 >( row ), rhs1, result );
+		result = SimdMath::MulAdd( SimdMath::Splat< 2 >( row ), rhs2, result );
+		tmp.rows[ i ] = Vec3( result );
+	}
+	return tmp;
+}
+#else
 inline Mat3 Mat3::operator * ( const Mat3 & rhs ) const {
 	Mat3 tmp;
 	for ( int i = 0; i < 3; i++ ) {
@@ -237,6 +294,8 @@ inline Mat3 Mat3::operator * ( const Mat3 & rhs ) const {
 	return tmp;
 }
 
+#endif
+
 inline Mat3 Mat3::operator + ( const Mat3 & rhs ) const {
 	Mat3 tmp;
 	for ( int i = 0; i < 3; i++ ) {
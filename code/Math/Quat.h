@@ -10,7 +10,7 @@
  Quat
  ================================
  */
-class Quat {
+class MATH_ALIGN Quat {
 public:
 	Quat();	
 	Quat( const Quat & rhs );
@@ -35,6 +35,8 @@ public:
 	Mat3	ToMat3() const;
 	Vec4	ToVec4() const { return Vec4( w, x, y, z ); }
 
+	static Quat Lerp( const Quat & a, const Quat & b, const float t );
+
 public:
 	float w;
 	float x;
@@ -100,6 +102,32 @@ inline Quat & Quat::operator *= ( const Quat & rhs ) {
 	return *this;
 }
 
+#if defined( MATH_SIMD )
+inline Quat Quat::operator * ( const Quat & rhs ) const {
+	// lanes are ( w, x, y, z ), each component of this scales a signed swizzle of rhs
+	const __m128 b = _mm_load_ps( &rhs.w );
+	const __m128 b_xwzy = _mm_xor_ps( _mm_shuffle_ps( b, b, _MM_SHUFFLE( 2, 3, 0, 1 ) ), _mm_set_ps( 0.0f, -0.0f, 0.0f, -0.0f ) );
+	const __m128 b_yzwx = _mm_xor_ps( _mm_shuffle_ps( b, b, _MM_SHUFFLE( 1, 0, 3, 2 ) ), _mm_set_ps( -0.0f, 0.0f, 0.0f, -0.0f ) );
+	const __m128 b_zyxw = _mm_xor_ps( _mm_shuffle_ps( b, b, _MM_SHUFFLE( 0, 1, 2, 3 ) ), _mm_set_ps( 0.0f, 0.0f, -0.0f, -0.0f ) );
+
+	__m128 result = _mm_mul_ps( _mm_set1_ps( w ), b );
+	result = SimdMath::MulAdd( _mm_set1_ps( x ), b_xwzy, result );
+	result = SimdMath::MulAdd( _mm_set1_ps( y ), b_yzwx, result );
+	result = SimdMath::MulAdd( _mm_set1_ps( z ), b_zyxw, result );
+
+	Quat temp;
+	_mm_store_ps( &temp.w, result );
+	return temp;
+}
+
+inline void Quat::Normalize() {
+	float invMag = 1.0f / GetMagnitude();
+	
+	if ( 0.0f * invMag == 0.0f * invMag ) {
+		_mm_store_ps( &w, _mm_mul_ps( _mm_load_ps( &w ), _mm_set1_ps( invMag ) ) );
+	}
+}
+#else
 inline Quat Quat::operator * ( const Quat & rhs ) const {
 	Quat temp;	
 	temp.w = ( w * rhs.w ) - ( x * rhs.x ) - ( y * rhs.y ) - ( z * rhs.z );
@@ -120,6 +148,8 @@ inline void Quat::Normalize() {
 	}
 }
 
+#endif
+
 inline void Quat::Invert() {
     *this *= 1.0f / MagnitudeSquared();
     x = -x;
@@ -133,20 +163,41 @@ inline Quat Quat::Inverse() const {
     return val;
 }
 
+#if defined( MATH_SIMD )
+inline float Quat::MagnitudeSquared() const {
+	const __m128 q = _mm_load_ps( &w );
+	return _mm_cvtss_f32( _mm_dp_ps( q, q, 0xf1 ) );
+}
+#else
 inline float Quat::MagnitudeSquared() const {
     return ( ( x * x ) + ( y * y ) + ( z * z ) + ( w * w ) );
 }
+#endif
 
 inline float Quat::GetMagnitude() const {
 	return sqrtf( MagnitudeSquared() );
 }
 
+#if defined( MATH_SIMD )
+inline Vec3 Quat::RotatePoint( const Vec3 & rhs ) const {
+	// q * v * q^-1 expanded, u being xyz: ( ( w² - u.u ) v + 2 ( u.v ) u + 2 w ( u x v ) ) / |q|²
+	const __m128 q = _mm_load_ps( &w );
+	const Vec3 u( _mm_blend_ps( _mm_shuffle_ps( q, q, _MM_SHUFFLE( 0, 3, 2, 1 ) ), _mm_setzero_ps(), 0x8 ) );
+
+	const float uu = u.Dot( u );
+	const float ww = w * w;
+	const Vec3 rotated = rhs * ( ww - uu ) + u * ( 2.0f * u.Dot( rhs ) ) + u.Cross( rhs ) * ( 2.0f * w );
+	return rotated * ( 1.0f / ( ww + uu ) );
+}
+#else
 inline Vec3 Quat::RotatePoint( const Vec3 & rhs ) const {
 	Quat vector( rhs.x, rhs.y, rhs.z, 0.0f );
 	Quat final = *this * vector * Inverse();
 	return Vec3( final.x, final.y, final.z );
 }
 
+#endif
+
 inline bool Quat::IsValid() const {
 	if ( x * 0 != x * 0 ) {
 		return false;
@@ -179,4 +230,19 @@ inline Mat3 Quat::ToMat3() const {
 	mat.rows[ 1 ] = RotatePoint( mat.rows[ 1 ] );
 	mat.rows[ 2 ] = RotatePoint( mat.rows[ 2 ] );
 	return mat;
-}
\ No newline at end of file
+}
+
+inline Quat Quat::Lerp( const Quat & a, const Quat & b, const float t ) {
+	// q and -q are the same rotation, go through the shortest arc
+	const float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	const float sign = dot < 0.0f ? -1.0f : 1.0f;
+
+	Quat result(
+		a.x + ( b.x * sign - a.x ) * t,
+		a.y + ( b.y * sign - a.y ) * t,
+		a.z + ( b.z * sign - a.z ) * t,
+		a.w + ( b.w * sign - a.w ) * t
+	);
+	result.Normalize();
+	return result;
+}
@@ -0,0 +1,201 @@
+//
+//	Simd.h
+//
+#pragma once
+#include <immintrin.h>
+
+/*
+ ================================
+ SimdFloat
+
+ A lane of SIMD_WIDTH floats, 8 wide on AVX2 targets and
+ 4 wide on plain SSE ones. Comparisons return a mask where
+ every bit of a lane is set when the test passes.
+ ================================
+ */
+#if defined( __AVX2__ )
+#define SIMD_WIDTH 8
+
+class SimdFloat {
+public:
+	SimdFloat() {}
+	SimdFloat( __m256 value ) : v( value ) {}
+
+	static SimdFloat	Broadcast( const float value ) { return _mm256_set1_ps( value ); }
+	static SimdFloat	Load( const float * data ) { return _mm256_loadu_ps( data ); }
+	void				Store( float * data ) const { _mm256_storeu_ps( data, v ); }
+
+	SimdFloat	operator + ( const SimdFloat & rhs ) const { return _mm256_add_ps( v, rhs.v ); }
+	SimdFloat	operator - ( const SimdFloat & rhs ) const { return _mm256_sub_ps( v, rhs.v ); }
+	SimdFloat	operator * ( const SimdFloat & rhs ) const { return _mm256_mul_ps( v, rhs.v ); }
+	SimdFloat	operator / ( const SimdFloat & rhs ) const { return _mm256_div_ps( v, rhs.v ); }
+
+	SimdFloat	operator & ( const SimdFloat & rhs ) const { return _mm256_and_ps( v, rhs.v ); }
+	SimdFloat	operator | ( const SimdFloat & rhs ) const { return _mm256_or_ps( v, rhs.v ); }
+
+	SimdFloat	Equal( const SimdFloat & rhs ) const { return _mm256_cmp_ps( v, rhs.v, _CMP_EQ_OQ ); }
+	SimdFloat	Less( const SimdFloat & rhs ) const { return _mm256_cmp_ps( v, rhs.v, _CMP_LT_OQ ); }
+	SimdFloat	LessEqual( const SimdFloat & rhs ) const { return _mm256_cmp_ps( v, rhs.v, _CMP_LE_OQ ); }
+	SimdFloat	Greater( const SimdFloat & rhs ) const { return _mm256_cmp_ps( v, rhs.v, _CMP_GT_OQ ); }
+
+	int			GetMask() const { return _mm256_movemask_ps( v ); }
+
+	static SimdFloat Select( const SimdFloat & mask, const SimdFloat & a, const SimdFloat & b ) {
+		return _mm256_blendv_ps( b.v, a.v, mask.v );
+	}
+	static SimdFloat Sqrt( const SimdFloat & a ) { return _mm256_sqrt_ps( a.v ); }
+	static SimdFloat Min( const SimdFloat & a, const SimdFloat & b ) { return _mm256_min_ps( a.v, b.v ); }
+	static SimdFloat Max( const SimdFloat & a, const SimdFloat & b ) { return _mm256_max_ps( a.v, b.v ); }
+
+public:
+	__m256 v;
+};
+
+#else
+#define SIMD_WIDTH 4
+
+class SimdFloat {
+public:
+	SimdFloat() {}
+	SimdFloat( __m128 value ) : v( value ) {}
+
+	static SimdFloat	Broadcast( const float value ) { return _mm_set1_ps( value ); }
+	static SimdFloat	Load( const float * data ) { return _mm_loadu_ps( data ); }
+	void				Store( float * data ) const { _mm_storeu_ps( data, v ); }
+
+	SimdFloat	operator + ( const SimdFloat & rhs ) const { return _mm_add_ps( v, rhs.v ); }
+	SimdFloat	operator - ( const SimdFloat & rhs ) const { return _mm_sub_ps( v, rhs.v ); }
+	SimdFloat	operator * ( const SimdFloat & rhs ) const { return _mm_mul_ps( v, rhs.v ); }
+	SimdFloat	operator / ( const SimdFloat & rhs ) const { return _mm_div_ps( v, rhs.v ); }
+
+	SimdFloat	operator & ( const SimdFloat & rhs ) const { return _mm_and_ps( v, rhs.v ); }
+	SimdFloat	operator | ( const SimdFloat & rhs ) const { return _mm_or_ps( v, rhs.v ); }
+
+	SimdFloat	Equal( const SimdFloat & rhs ) const { return _mm_cmpeq_ps( v, rhs.v ); }
+	SimdFloat	Less( const SimdFloat & rhs ) const { return _mm_cmplt_ps( v, rhs.v ); }
+	SimdFloat	LessEqual( const SimdFloat & rhs ) const { return _mm_cmple_ps( v, rhs.v ); }
+	SimdFloat	Greater( const SimdFloat & rhs ) const { return _mm_cmpgt_ps( v, rhs.v ); }
+
+	int			GetMask() const { return _mm_movemask_ps( v ); }
+
+	//	plain SSE, no need for the SSE4.1 blend
+	static SimdFloat Select( const SimdFloat & mask, const SimdFloat & a, const SimdFloat & b ) {
+		return _mm_or_ps( _mm_and_ps( mask.v, a.v ), _mm_andnot_ps( mask.v, b.v ) );
+	}
+	static SimdFloat Sqrt( const SimdFloat & a ) { return _mm_sqrt_ps( a.v ); }
+	static SimdFloat Min( const SimdFloat & a, const SimdFloat & b ) { return _mm_min_ps( a.v, b.v ); }
+	static SimdFloat Max( const SimdFloat & a, const SimdFloat & b ) { return _mm_max_ps( a.v, b.v ); }
+
+public:
+	__m128 v;
+};
+
+#endif
+
+/*
+ ================================
+ SimdVec3
+
+ Structure of arrays, one Vec3 per lane
+ ================================
+ */
+class SimdVec3 {
+public:
+	SimdVec3() {}
+	SimdVec3( const SimdFloat & X, const SimdFloat & Y, const SimdFloat & Z ) : x( X ), y( Y ), z( Z ) {}
+
+	//	xyz holds 3 arrays of SIMD_WIDTH floats
+	static SimdVec3 Load( const float * xs, const float * ys, const float * zs ) {
+		return SimdVec3( SimdFloat::Load( xs ), SimdFloat::Load( ys ), SimdFloat::Load( zs ) );
+	}
+	void Store( float * xs, float * ys, float * zs ) const {
+		x.Store( xs );
+		y.Store( ys );
+		z.Store( zs );
+	}
+
+	SimdVec3	operator + ( const SimdVec3 & rhs ) const { return SimdVec3( x + rhs.x, y + rhs.y, z + rhs.z ); }
+	SimdVec3	operator - ( const SimdVec3 & rhs ) const { return SimdVec3( x - rhs.x, y - rhs.y, z - rhs.z ); }
+	SimdVec3	operator * ( const SimdFloat & rhs ) const { return SimdVec3( x * rhs, y * rhs, z * rhs ); }
+
+	SimdFloat	Dot( const SimdVec3 & rhs ) const { return x * rhs.x + y * rhs.y + z * rhs.z; }
+	SimdVec3	Cross( const SimdVec3 & rhs ) const {
+		return SimdVec3(
+			y * rhs.z - z * rhs.y,
+			z * rhs.x - x * rhs.z,
+			x * rhs.y - y * rhs.x
+		);
+	}
+
+	static SimdVec3 Select( const SimdFloat & mask, const SimdVec3 & a, const SimdVec3 & b ) {
+		return SimdVec3(
+			SimdFloat::Select( mask, a.x, b.x ),
+			SimdFloat::Select( mask, a.y, b.y ),
+			SimdFloat::Select( mask, a.z, b.z )
+		);
+	}
+
+public:
+	SimdFloat x;
+	SimdFloat y;
+	SimdFloat z;
+};
+
+/*
+ ================================
+ SimdMat3
+ ================================
+ */
+class SimdMat3 {
+public:
+	SimdMat3() {}
+
+	SimdVec3 operator * ( const SimdVec3 & rhs ) const {
+		return SimdVec3( rows[ 0 ].Dot( rhs ), rows[ 1 ].Dot( rhs ), rows[ 2 ].Dot( rhs ) );
+	}
+
+public:
+	SimdVec3 rows[ 3 ];
+};
+
+/*
+ ================================
+ SimdQuat
+
+ Structure of arrays, one Quat per lane
+ ================================
+ */
+class SimdQuat {
+public:
+	SimdQuat() {}
+	SimdQuat( const SimdFloat & W, const SimdVec3 & XYZ ) : w( W ), xyz( XYZ ) {}
+
+	//	q * v * q^-1 expanded, so quaternions don't need to be normalized
+	SimdVec3 RotatePoint( const SimdVec3 & rhs ) const {
+		const SimdFloat two = SimdFloat::Broadcast( 2.0f );
+		const SimdFloat ww = w * w;
+		const SimdFloat uu = xyz.Dot( xyz );
+		const SimdVec3 rotated = rhs * ( ww - uu ) + xyz * ( two * xyz.Dot( rhs ) ) + xyz.Cross( rhs ) * ( two * w );
+		return rotated * ( SimdFloat::Broadcast( 1.0f ) / ( ww + uu ) );
+	}
+
+	//	rows are the rotated x, y and z axis
+	SimdMat3 ToAxis() const {
+		const SimdFloat two = SimdFloat::Broadcast( 2.0f );
+		const SimdFloat invMag = SimdFloat::Broadcast( 1.0f ) / ( w * w + xyz.Dot( xyz ) );
+		const SimdFloat diag = w * w - xyz.Dot( xyz );
+		const SimdFloat & x = xyz.x;
+		const SimdFloat & y = xyz.y;
+		const SimdFloat & z = xyz.z;
+
+		SimdMat3 axis;
+		axis.rows[ 0 ] = SimdVec3( diag + two * x * x, two * ( x * y + w * z ), two * ( x * z - w * y ) ) * invMag;
+		axis.rows[ 1 ] = SimdVec3( two * ( x * y - w * z ), diag + two * y * y, two * ( y * z + w * x ) ) * invMag;
+		axis.rows[ 2 ] = SimdVec3( two * ( x * z + w * y ), two * ( y * z - w * x ), diag + two * z * z ) * invMag;
+		return axis;
+	}
+
+public:
+	SimdFloat w;
+	SimdVec3 xyz;
+};
@@ -0,0 +1,100 @@
+//
+//	Transforms.cpp
+//
+#include "Transforms.h"
+#include "Simd.h"
+#include <algorithm>
+
+/*
+ ================================
+ TransformLanes
+
+ A block of SIMD_WIDTH bodies gathered in structure of arrays.
+ Lanes past the end of the input are padded with identities,
+ they are computed but never scattered back.
+ ================================
+ */
+struct TransformLanes {
+	float qw[ SIMD_WIDTH ];
+	float qx[ SIMD_WIDTH ];
+	float qy[ SIMD_WIDTH ];
+	float qz[ SIMD_WIDTH ];
+	float px[ SIMD_WIDTH ];
+	float py[ SIMD_WIDTH ];
+	float pz[ SIMD_WIDTH ];
+
+	void Gather( const Quat * quats, const Vec3 * points, const int count ) {
+		for ( int i = 0; i < SIMD_WIDTH; i++ ) {
+			const Quat q = ( i < count ) ? quats[ i ] : Quat();
+			const Vec3 p = ( i < count ) ? points[ i ] : Vec3( 0.0f );
+			qw[ i ] = q.w;
+			qx[ i ] = q.x;
+			qy[ i ] = q.y;
+			qz[ i ] = q.z;
+			px[ i ] = p.x;
+			py[ i ] = p.y;
+			pz[ i ] = p.z;
+		}
+	}
+
+	SimdQuat GetQuat() const {
+		return SimdQuat( SimdFloat::Load( qw ), SimdVec3::Load( qx, qy, qz ) );
+	}
+	SimdVec3 GetPoint() const {
+		return SimdVec3::Load( px, py, pz );
+	}
+};
+
+/*
+====================================================
+RotatePoints
+====================================================
+*/
+void RotatePoints( const Quat * quats, const Vec3 * points, Vec3 * out, const int num ) {
+	TransformLanes lanes;
+	float xs[ SIMD_WIDTH ];
+	float ys[ SIMD_WIDTH ];
+	float zs[ SIMD_WIDTH ];
+
+	for ( int start = 0; start < num; start += SIMD_WIDTH ) {
+		const int count = std::min( SIMD_WIDTH, num - start );
+		lanes.Gather( quats + start, points + start, count );
+
+		const SimdVec3 rotated = lanes.GetQuat().RotatePoint( lanes.GetPoint() );
+		rotated.Store( xs, ys, zs );
+
+		for ( int i = 0; i < count; i++ ) {
+			out[ start + i ] = Vec3( xs[ i ], ys[ i ], zs[ i ] );
+		}
+	}
+}
+
+/*
+====================================================
+BuildModelMatrices
+====================================================
+*/
+void BuildModelMatrices( const Vec3 * positions, const Quat * quats, Mat4 * out, const int num ) {
+	TransformLanes lanes;
+	float axis[ 3 ][ 3 ][ SIMD_WIDTH ];
+
+	for ( int start = 0; start < num; start += SIMD_WIDTH ) {
+		const int count = std::min( SIMD_WIDTH, num - start );
+		lanes.Gather( quats + start, positions + start, count );
+
+		const SimdMat3 rotation = lanes.GetQuat().ToAxis();
+		for ( int r = 0; r < 3; r++ ) {
+			rotation.rows[ r ].Store( axis[ r ][ 0 ], axis[ r ][ 1 ], axis[ r ][ 2 ] );
+		}
+
+		// Orient puts fwd, left and up in the columns, so once transposed
+		// they are the rows, and the position is the last one
+		for ( int i = 0; i < count; i++ ) {
+			Mat4 & mat = out[ start + i ];
+			for ( int r = 0; r < 3; r++ ) {
+				mat.rows[ r ] = Vec4( axis[ r ][ 0 ][ i ], axis[ r ][ 1 ][ i ], axis[ r ][ 2 ][ i ], 0.0f );
+			}
+			mat.rows[ 3 ] = Vec4( lanes.px[ i ], lanes.py[ i ], lanes.pz[ i ], 1.0f );
+		}
+	}
+}
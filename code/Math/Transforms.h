@@ -0,0 +1,28 @@
+//
+//	Transforms.h
+//
+#pragma once
+#include "Vector.h"
+#include "Matrix.h"
+#include "Quat.h"
+
+/*
+====================================================
+RotatePoints
+
+out[ i ] = quats[ i ].RotatePoint( points[ i ] ), SIMD_WIDTH
+bodies at a time. out may alias points.
+====================================================
+*/
+void RotatePoints( const Quat * quats, const Vec3 * points, Vec3 * out, const int num );
+
+/*
+====================================================
+BuildModelMatrices
+
+Same as Mat4::Orient from the rotated axis of each quat,
+then Transpose, SIMD_WIDTH bodies at a time. The matrices
+are ready to be copied into the uniform buffers.
+====================================================
+*/
+void BuildModelMatrices( const Vec3 * positions, const Quat * quats, Mat4 * out, const int num );
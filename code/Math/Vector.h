@@ -6,6 +6,29 @@
 #include <assert.h>
 #include <stdio.h>
 
+//	Define MATH_SIMD project-wide to back Vec3, Vec4, Quat and Mat3 with SSE4.1 registers,
+//	using FMA on AVX2 targets. The API is the same, the scalar code stays the reference.
+#if defined( MATH_SIMD )
+#include <immintrin.h>
+
+#define MATH_ALIGN alignas( 16 )
+
+namespace SimdMath {
+	inline __m128 MulAdd( const __m128 & a, const __m128 & b, const __m128 & c ) {
+#if defined( __AVX2__ )
+		return _mm_fmadd_ps( a, b, c );
+#else
+		return _mm_add_ps( _mm_mul_ps( a, b ), c );
+#endif
+	}
+
+	template < int lane >
+	inline __m128 Splat( const __m128 & a ) { return _mm_shuffle_ps( a, a, _MM_SHUFFLE( lane, lane, lane, lane ) ); }
+}
+#else
+#define MATH_ALIGN
+#endif
+
 /*
  ================================
  Vec2
@@ -188,7 +211,7 @@ inline bool Vec2::IsValid() const {
  Vec3
  ================================
  */
-class Vec3 {
+class MATH_ALIGN Vec3 {
 public:
 	Vec3();
 	Vec3( float value );
@@ -224,12 +247,139 @@ public:
 	
 	const float * ToPtr() const { return &x; }
 
+#if defined( MATH_SIMD )
+	explicit Vec3( const __m128 & xyzw ) { _mm_store_ps( &x, xyzw ); }
+	__m128 GetSimd() const { return _mm_load_ps( &x ); }
+#endif
+
 public:
 	float x;
 	float y;
 	float z;
+#if defined( MATH_SIMD )
+	float w;	// padding lane, never read back
+#endif
 };
 
+#if defined( MATH_SIMD )
+inline Vec3::Vec3() {
+	_mm_store_ps( &x, _mm_setzero_ps() );
+}
+
+inline Vec3::Vec3( float value ) {
+	_mm_store_ps( &x, _mm_set_ps( 0.0f, value, value, value ) );
+}
+
+inline Vec3::Vec3( const Vec3 &rhs ) {
+	_mm_store_ps( &x, rhs.GetSimd() );
+}
+
+inline Vec3::Vec3( float X, float Y, float Z ) {
+	_mm_store_ps( &x, _mm_set_ps( 0.0f, Z, Y, X ) );
+}
+
+inline Vec3::Vec3( const float * xyz ) {
+	_mm_store_ps( &x, _mm_set_ps( 0.0f, xyz[ 2 ], xyz[ 1 ], xyz[ 0 ] ) );
+}
+
+inline Vec3 & Vec3::operator = ( const Vec3 & rhs ) {
+	_mm_store_ps( &x, rhs.GetSimd() );
+	return *this;
+}
+
+inline Vec3& Vec3::operator=( const float * rhs ) {
+	_mm_store_ps( &x, _mm_set_ps( 0.0f, rhs[ 2 ], rhs[ 1 ], rhs[ 0 ] ) );
+	return *this;
+}
+
+inline bool Vec3::operator == ( const Vec3 & rhs ) const {
+	const int equal = _mm_movemask_ps( _mm_cmpeq_ps( GetSimd(), rhs.GetSimd() ) );
+	return ( equal & 0x7 ) == 0x7;
+}
+
+inline bool Vec3::operator != ( const Vec3 & rhs ) const {
+	if ( *this == rhs ) {
+		return false;
+	}
+	
+	return true;
+}
+
+inline Vec3 Vec3::operator + ( const Vec3 & rhs ) const {
+	return Vec3( _mm_add_ps( GetSimd(), rhs.GetSimd() ) );
+}
+
+inline const Vec3 & Vec3::operator += ( const Vec3 & rhs ) {
+	_mm_store_ps( &x, _mm_add_ps( GetSimd(), rhs.GetSimd() ) );
+	return *this;
+}
+
+inline const Vec3 & Vec3::operator -= ( const Vec3 & rhs ) {
+	_mm_store_ps( &x, _mm_sub_ps( GetSimd(), rhs.GetSimd() ) );
+	return *this;
+}
+
+inline Vec3 Vec3::operator - ( const Vec3 & rhs ) const {
+	return Vec3( _mm_sub_ps( GetSimd(), rhs.GetSimd() ) );
+}
+
+inline Vec3 Vec3::operator * ( const float rhs ) const {
+	return Vec3( _mm_mul_ps( GetSimd(), _mm_set1_ps( rhs ) ) );
+}
+
+inline Vec3 Vec3::operator / ( const float rhs ) const {
+	return Vec3( _mm_div_ps( GetSimd(), _mm_set1_ps( rhs ) ) );
+}
+
+inline const Vec3 & Vec3::operator *= ( const float rhs ) {
+	_mm_store_ps( &x, _mm_mul_ps( GetSimd(), _mm_set1_ps( rhs ) ) );
+	return *this;
+}
+
+inline const Vec3 & Vec3::operator /= ( const float rhs ) {
+	_mm_store_ps( &x, _mm_div_ps( GetSimd(), _mm_set1_ps( rhs ) ) );
+	return *this;
+}
+
+inline float Vec3::operator [] ( const int idx ) const {
+	assert( idx >= 0 && idx < 3 );
+	return ( &x )[ idx ];
+}
+
+inline float & Vec3::operator [] ( const int idx ) {
+	assert( idx >= 0 && idx < 3 );
+	return ( &x )[ idx ];
+}
+
+inline Vec3 Vec3::Cross( const Vec3 & rhs ) const {
+	// a * b.yzx - a.yzx * b gives the cross product in zxy order
+	const __m128 a = GetSimd();
+	const __m128 b = rhs.GetSimd();
+	const __m128 a_yzx = _mm_shuffle_ps( a, a, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+	const __m128 b_yzx = _mm_shuffle_ps( b, b, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+	const __m128 c = _mm_sub_ps( _mm_mul_ps( a, b_yzx ), _mm_mul_ps( a_yzx, b ) );
+	return Vec3( _mm_shuffle_ps( c, c, _MM_SHUFFLE( 3, 0, 2, 1 ) ) );
+}
+
+inline float Vec3::Dot( const Vec3 & rhs ) const {
+	// the padding lane is left out of the sum
+	return _mm_cvtss_f32( _mm_dp_ps( GetSimd(), rhs.GetSimd(), 0x71 ) );
+}
+
+inline const Vec3 & Vec3::Normalize() {
+	float mag = GetMagnitude();
+	float invMag = 1.0f / mag;
+	if ( 0.0f * invMag == 0.0f * invMag ) {
+		_mm_store_ps( &x, _mm_mul_ps( GetSimd(), _mm_set1_ps( invMag ) ) );
+	}
+    return *this;
+}
+
+inline float Vec3::GetMagnitude() const {
+	const __m128 a = GetSimd();
+	return _mm_cvtss_f32( _mm_sqrt_ss( _mm_dp_ps( a, a, 0x71 ) ) );
+}
+#else
 inline Vec3::Vec3() :
 x( 0 ),
 y( 0 ),
@@ -402,6 +552,8 @@ inline float Vec3::GetMagnitude() const {
 	return mag;
 }
 
+#endif
+
 inline bool Vec3::IsValid() const {
 	if ( x * 0.0f != x * 0.0f ) {
 		return false;
@@ -437,7 +589,7 @@ inline void Vec3::GetOrtho( Vec3 & u, Vec3 & v ) const {
  Vec4
  ================================
  */
-class Vec4 {
+class MATH_ALIGN Vec4 {
 public:
 	Vec4();
 	Vec4( const float value );
@@ -466,6 +618,11 @@ public:
 	
     const float *   ToPtr() const   { return &x; }
 	float *         ToPtr()         { return &x; }
+
+#if defined( MATH_SIMD )
+	explicit Vec4( const __m128 & xyzw ) { _mm_store_ps( &x, xyzw ); }
+	__m128 GetSimd() const { return _mm_load_ps( &x ); }
+#endif
 	
 public:
 	float x;
@@ -488,6 +645,97 @@ z( value ),
 w( value ) {
 }
 
+#if defined( MATH_SIMD )
+inline Vec4::Vec4( const Vec4 & rhs ) {
+	_mm_store_ps( &x, rhs.GetSimd() );
+}
+
+inline Vec4::Vec4( float X, float Y, float Z, float W ) {
+	_mm_store_ps( &x, _mm_set_ps( W, Z, Y, X ) );
+}
+
+inline Vec4::Vec4( const float * rhs ) {
+	_mm_store_ps( &x, _mm_loadu_ps( rhs ) );
+}
+
+inline Vec4 & Vec4::operator = ( const Vec4 & rhs ) {
+	_mm_store_ps( &x, rhs.GetSimd() );
+	return *this;
+}
+
+inline bool Vec4::operator == ( const Vec4 & rhs ) const {
+	return _mm_movemask_ps( _mm_cmpeq_ps( GetSimd(), rhs.GetSimd() ) ) == 0xf;
+}
+
+inline bool Vec4::operator != ( const Vec4 & rhs ) const {
+	if ( *this == rhs ) {
+		return false;
+	}
+	
+	return true;
+}
+
+inline Vec4 Vec4::operator + ( const Vec4 & rhs ) const {
+	return Vec4( _mm_add_ps( GetSimd(), rhs.GetSimd() ) );
+}
+
+inline const Vec4 & Vec4::operator += ( const Vec4 & rhs ) {
+	_mm_store_ps( &x, _mm_add_ps( GetSimd(), rhs.GetSimd() ) );
+	return *this;
+}
+
+inline const Vec4 & Vec4::operator -= ( const Vec4 & rhs ) {
+	_mm_store_ps( &x, _mm_sub_ps( GetSimd(), rhs.GetSimd() ) );
+	return *this;
+}
+
+inline const Vec4 & Vec4::operator *= ( const Vec4 & rhs ) {
+	_mm_store_ps( &x, _mm_mul_ps( GetSimd(), rhs.GetSimd() ) );
+	return *this;
+}
+
+inline const Vec4 & Vec4::operator /= ( const Vec4 & rhs ) {
+	_mm_store_ps( &x, _mm_div_ps( GetSimd(), rhs.GetSimd() ) );
+	return *this;
+}
+
+inline Vec4 Vec4::operator - ( const Vec4 & rhs ) const {
+	return Vec4( _mm_sub_ps( GetSimd(), rhs.GetSimd() ) );
+}
+
+inline Vec4 Vec4::operator * ( const float rhs ) const {
+	return Vec4( _mm_mul_ps( GetSimd(), _mm_set1_ps( rhs ) ) );
+}
+
+inline float Vec4::operator [] ( const int idx ) const {
+	assert( idx >= 0 && idx < 4 );
+	return ( &x )[ idx ];
+}
+
+inline float& Vec4::operator [] ( const int idx ) {
+	assert( idx >= 0 && idx < 4 );
+	return ( &x )[ idx ];
+}
+
+inline float Vec4::Dot( const Vec4 & rhs ) const {
+	return _mm_cvtss_f32( _mm_dp_ps( GetSimd(), rhs.GetSimd(), 0xf1 ) );
+}
+
+inline const Vec4 & Vec4::Normalize() {
+	float mag = GetMagnitude();
+	float invMag = 1.0f / mag;
+	if ( 0.0f * invMag == 0.0f * invMag ) {
+		_mm_store_ps( &x, _mm_mul_ps( GetSimd(), _mm_set1_ps( invMag ) ) );
+	}
+    
+    return *this;
+}
+
+inline float Vec4::GetMagnitude() const {
+	const __m128 a = GetSimd();
+	return _mm_cvtss_f32( _mm_sqrt_ss( _mm_dp_ps( a, a, 0xf1 ) ) );
+}
+#else
 inline Vec4::Vec4( const Vec4 & rhs ) :
 x( rhs.x ),
 y( rhs.y ),
@@ -644,6 +892,8 @@ inline float Vec4::GetMagnitude() const {
 	return mag;
 }
 
+#endif
+
 inline bool Vec4::IsValid() const {
 	if ( x * 0.0f != x * 0.0f ) {
 		return false;
@@ -0,0 +1,390 @@
+#include "Narrowphase.h"
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+
+#include "Math/Simd.h"
+
+#include "Intersection.h"
+#include "Shape.h"
+
+PairCache& PairCaches::Get( int id_a, int id_b )
+{
+	const unsigned long long key = ( (unsigned long long) std::min( id_a, id_b ) << 32 ) | (unsigned int) std::max( id_a, id_b );
+
+	PairCache& cache = caches[key];
+	cache.lastStep = step;
+	return cache;
+}
+
+void PairCaches::NextStep()
+{
+	for ( auto itr = caches.begin(); itr != caches.end(); )
+	{
+		if ( itr->second.lastStep != step )
+		{
+			itr = caches.erase( itr );
+			continue;
+		}
+		++itr;
+	}
+
+	step++;
+}
+
+void SpherePairs::Add( int id_a, int id_b, const Body& body_a, const Body& body_b, float radius_a, float radius_b )
+{
+	count++;
+	a.push_back( id_a );
+	b.push_back( id_b );
+
+	for ( int i = 0; i < 3; i++ )
+	{
+		positionA[i].push_back( body_a.position[i] );
+		velocityA[i].push_back( body_a.linearVelocity[i] );
+		positionB[i].push_back( body_b.position[i] );
+		velocityB[i].push_back( body_b.linearVelocity[i] );
+	}
+	radiusA.push_back( radius_a );
+	radiusB.push_back( radius_b );
+}
+
+void SpherePairs::Pad()
+{
+	//  padding lanes are masked out of the hits, zeros only keep them finite
+	const int padded_count = ( count + SIMD_WIDTH - 1 ) / SIMD_WIDTH * SIMD_WIDTH;
+	for ( int i = 0; i < 3; i++ )
+	{
+		positionA[i].resize( padded_count, 0.0f );
+		velocityA[i].resize( padded_count, 0.0f );
+		positionB[i].resize( padded_count, 0.0f );
+		velocityB[i].resize( padded_count, 0.0f );
+	}
+	radiusA.resize( padded_count, 0.0f );
+	radiusB.resize( padded_count, 0.0f );
+}
+
+static SimdVec3 LoadLanes( const std::vector<float> ( &values )[3], int i )
+{
+	return SimdVec3::Load( &values[0][i], &values[1][i], &values[2][i] );
+}
+
+void SphereToSphereHits( const SpherePairs& pairs, const float dt, std::vector<SphereHit>& hits )
+{
+	hits.clear();
+
+	const SimdFloat zero = SimdFloat::Broadcast( 0.0f );
+	const SimdFloat one = SimdFloat::Broadcast( 1.0f );
+	const SimdFloat simd_dt = SimdFloat::Broadcast( dt );
+	const SimdFloat short_ray_length_sqr = SimdFloat::Broadcast( 0.001f * 0.001f );
+	const SimdFloat short_ray_radius_margin = SimdFloat::Broadcast( 0.001f );
+
+	for ( int i = 0; i < pairs.count; i += SIMD_WIDTH )
+	{
+		const SimdVec3 pos_a = LoadLanes( pairs.positionA, i );
+		const SimdVec3 vel_a = LoadLanes( pairs.velocityA, i );
+		const SimdVec3 pos_b = LoadLanes( pairs.positionB, i );
+		const SimdVec3 vel_b = LoadLanes( pairs.velocityB, i );
+		const SimdFloat radius_a = SimdFloat::Load( &pairs.radiusA[i] );
+		const SimdFloat radius_b = SimdFloat::Load( &pairs.radiusB[i] );
+		const SimdFloat radius = radius_a + radius_b;
+
+		const SimdVec3 relative_vel = vel_a - vel_b;
+		const SimdVec3 end_point_a = pos_a + relative_vel * simd_dt;
+		const SimdVec3 ray_dir = end_point_a - pos_a;
+		const SimdVec3 ab = pos_b - pos_a;
+
+		//  ray is too short, check for intersection
+		const SimdFloat ray_length_sqr = ray_dir.Dot( ray_dir );
+		const SimdFloat is_short = ray_length_sqr.LessEqual( short_ray_length_sqr );
+		const SimdFloat short_radius = radius + short_ray_radius_margin;
+		const int short_hits = ~( short_radius * short_radius ).Less( ab.Dot( ab ) ).GetMask();
+
+		//  Intersection::RaySphere
+		const SimdFloat b = ab.Dot( ray_dir );
+		const SimdFloat c = ab.Dot( ab ) - radius * radius;
+		const SimdFloat delta = b * b - ray_length_sqr * c;
+		const int ray_hits = ~delta.Less( zero ).GetMask();
+
+		const SimdFloat inverse_a = one / SimdFloat::Select( is_short, one, ray_length_sqr );
+		const SimdFloat delta_root = SimdFloat::Sqrt( SimdFloat::Max( delta, zero ) );
+		const SimdFloat t0 = SimdFloat::Select( is_short, zero, ( b - delta_root ) * inverse_a ) * simd_dt;
+		const SimdFloat t1 = SimdFloat::Select( is_short, zero, ( b + delta_root ) * inverse_a ) * simd_dt;
+
+		const int short_mask = is_short.GetMask();
+		int hits_mask = ( short_mask & short_hits ) | ( ~short_mask & ray_hits );
+
+		//  avoid collision in the past
+		hits_mask &= ~t1.Less( zero ).GetMask();
+
+		//  get earliest positive time of impact, avoid too far collision in time
+		const SimdFloat impact_time = SimdFloat::Select( t0.Less( zero ), zero, t0 );
+		hits_mask &= ~simd_dt.Less( impact_time ).GetMask();
+
+		//  discard padding lanes
+		const int lanes_count = pairs.count - i < SIMD_WIDTH ? pairs.count - i : SIMD_WIDTH;
+		hits_mask &= ( 1 << lanes_count ) - 1;
+		if ( hits_mask == 0 ) continue;
+
+		const SimdVec3 new_pos_a = pos_a + vel_a * impact_time;
+		const SimdVec3 new_pos_b = pos_b + vel_b * impact_time;
+		const SimdVec3 new_ab = new_pos_b - new_pos_a;
+		const SimdFloat length = SimdFloat::Sqrt( new_ab.Dot( new_ab ) );
+
+		//  same as Vec3::Normalize, a null vector is left untouched
+		const SimdFloat inverse_length = one / length;
+		const SimdFloat is_finite = ( zero * inverse_length ).Equal( zero * inverse_length );
+		const SimdVec3 direction = SimdVec3::Select( is_finite, new_ab * inverse_length, new_ab );
+
+		const SimdVec3 point_a = new_pos_a + direction * radius_a;
+		const SimdVec3 point_b = new_pos_b - direction * radius_b;
+		const SimdVec3 normal = direction * SimdFloat::Broadcast( -1.0f );
+		const SimdFloat separation = length - radius;
+
+		float lanes[11][SIMD_WIDTH];
+		impact_time.Store( lanes[0] );
+		separation.Store( lanes[1] );
+		normal.Store( lanes[2], lanes[3], lanes[4] );
+		point_a.Store( lanes[5], lanes[6], lanes[7] );
+		point_b.Store( lanes[8], lanes[9], lanes[10] );
+
+		//  compact hits
+		for ( int lane = 0; lane < lanes_count; lane++ )
+		{
+			if ( ( hits_mask & ( 1 << lane ) ) == 0 ) continue;
+
+			SphereHit hit;
+			hit.pair = i + lane;
+			hit.impactTime = lanes[0][lane];
+			hit.separationDistance = lanes[1][lane];
+			hit.normal = Vec3( lanes[2][lane], lanes[3][lane], lanes[4][lane] );
+			hit.pointA = Vec3( lanes[5][lane], lanes[6][lane], lanes[7][lane] );
+			hit.pointB = Vec3( lanes[8][lane], lanes[9][lane], lanes[10][lane] );
+			hits.push_back( hit );
+		}
+	}
+}
+
+//  compilers may fuse the scalar multiply-adds, which the SIMD lanes never do
+static bool IsSameFloat( const float a, const float b )
+{
+	return fabsf( a - b ) <= 1e-5f * std::max( 1.0f, std::max( fabsf( a ), fabsf( b ) ) );
+}
+
+static bool IsSameVector( const Vec3& a, const Vec3& b )
+{
+	return IsSameFloat( a.x, b.x ) && IsSameFloat( a.y, b.y ) && IsSameFloat( a.z, b.z );
+}
+
+int CheckSphereToSphereHits( const int pairs_count, const float dt, const unsigned int seed )
+{
+	std::mt19937 rng( seed );
+	std::uniform_real_distribution<float> position_dist( -2.0f, 2.0f );
+	std::uniform_real_distribution<float> velocity_dist( -20.0f, 20.0f );
+	std::uniform_real_distribution<float> radius_dist( 0.05f, 0.5f );
+	std::uniform_int_distribution<int> still_dist( 0, 9 );
+
+	std::vector<ShapeSphere> spheres;
+	std::vector<Body> bodies( pairs_count * 2 );
+	SpherePairs sphere_pairs;
+	spheres.reserve( pairs_count * 2 );
+	for ( int i = 0; i < pairs_count; i++ )
+	{
+		Body& a = bodies[i * 2];
+		Body& b = bodies[i * 2 + 1];
+		for ( Body* body : { &a, &b } )
+		{
+			spheres.push_back( ShapeSphere( radius_dist( rng ) ) );
+			body->shape = &spheres.back();
+			body->position = Vec3( position_dist( rng ), position_dist( rng ), position_dist( rng ) );
+			body->linearVelocity = Vec3( velocity_dist( rng ), velocity_dist( rng ), velocity_dist( rng ) );
+		}
+
+		//  also cover the short ray branch
+		if ( still_dist( rng ) == 0 )
+		{
+			b.linearVelocity = a.linearVelocity;
+		}
+
+		sphere_pairs.Add( i * 2, i * 2 + 1, a, b, spheres[i * 2].radius, spheres[i * 2 + 1].radius );
+	}
+	sphere_pairs.Pad();
+
+	std::vector<SphereHit> hits;
+	SphereToSphereHits( sphere_pairs, dt, hits );
+
+	int mismatches_count = 0;
+	int hit_id = 0;
+	for ( int i = 0; i < pairs_count; i++ )
+	{
+		const Body& a = bodies[i * 2];
+		const Body& b = bodies[i * 2 + 1];
+		const ShapeSphere& sphere_a = spheres[i * 2];
+		const ShapeSphere& sphere_b = spheres[i * 2 + 1];
+
+		//  same as Intersection::SphereToSphere
+		Vec3 point_a, point_b;
+		float impact_time = 0.0f;
+		const bool is_hit = Intersection::DynamicSphereToSphere( 
+			sphere_a, sphere_b, 
+			a.position, b.position, 
+			a.linearVelocity, b.linearVelocity, 
+			dt, 
+			point_a, point_b, impact_time 
+		);
+
+		const bool is_simd_hit = hit_id < (int) hits.size() && hits[hit_id].pair == i;
+		if ( !is_hit && !is_simd_hit ) continue;
+
+		bool is_same = is_hit == is_simd_hit;
+		if ( is_same )
+		{
+			const SphereHit& hit = hits[hit_id];
+			Vec3 impact_ab = ( a.position + a.linearVelocity * impact_time )
+				           - ( b.position + b.linearVelocity * impact_time );
+			const float separation = impact_ab.GetMagnitude() - ( sphere_a.radius + sphere_b.radius );
+			impact_ab.Normalize();
+
+			is_same = IsSameFloat( hit.impactTime, impact_time ) 
+				   && IsSameFloat( hit.separationDistance, separation ) 
+				   && IsSameVector( hit.normal, impact_ab ) 
+				   && IsSameVector( hit.pointA, point_a ) 
+				   && IsSameVector( hit.pointB, point_b );
+		}
+		if ( is_simd_hit ) hit_id++;
+
+		if ( !is_same )
+		{
+			if ( mismatches_count == 0 )
+			{
+				printf( "ERROR: sphere pair %i differs between the scalar and SIMD time of impact\n", i );
+			}
+			mismatches_count++;
+		}
+	}
+
+	return mismatches_count;
+}
+
+void SortPairsByShapes( 
+	const std::vector<Body>& bodies, 
+	const std::vector<CollisionPair>& pairs, 
+	std::vector<CollisionPair> ( &shape_pairs )[SHAPE_PAIRS_NUM] 
+)
+{
+	for ( int i = 0; i < SHAPE_PAIRS_NUM; i++ )
+	{
+		shape_pairs[i].clear();
+	}
+
+	for ( int i = 0; i < pairs.size(); i++ )
+	{
+		const CollisionPair& pair = pairs[i];
+		const Body& a = bodies[pair.a];
+		const Body& b = bodies[pair.b];
+
+		if ( a.IsStatic() && b.IsStatic() ) continue;
+
+		const int type_a = (int) a.shape->GetType();
+		const int type_b = (int) b.shape->GetType();
+		shape_pairs[type_a * SHAPE_TYPES_NUM + type_b].push_back( pair );
+	}
+}
+
+void SphereToSphereContacts( 
+	std::vector<Body>& bodies, 
+	const std::vector<CollisionPair>& pairs, 
+	const float dt, 
+	std::vector<Contact>& contacts 
+)
+{
+	SpherePairs sphere_pairs;
+	for ( const CollisionPair& pair : pairs )
+	{
+		const Body& a = bodies[pair.a];
+		const Body& b = bodies[pair.b];
+
+		const float radius_a = static_cast<const ShapeSphere*>( a.shape )->radius;
+		const float radius_b = static_cast<const ShapeSphere*>( b.shape )->radius;
+		sphere_pairs.Add( pair.a, pair.b, a, b, radius_a, radius_b );
+	}
+	sphere_pairs.Pad();
+
+	std::vector<SphereHit> hits;
+	SphereToSphereHits( sphere_pairs, dt, hits );
+
+	for ( const SphereHit& hit : hits )
+	{
+		Contact contact;
+		contact.bodyA = &bodies[sphere_pairs.a[hit.pair]];
+		contact.bodyB = &bodies[sphere_pairs.b[hit.pair]];
+		contact.impactTime = hit.impactTime;
+		contact.separationDistance = hit.separationDistance;
+		contact.normal = hit.normal;
+		contact.worldContactA = hit.pointA;
+		contact.worldContactB = hit.pointB;
+
+		Intersection::ComputeLocalContacts( *contact.bodyA, *contact.bodyB, contact );
+		contacts.push_back( contact );
+	}
+}
+
+void Narrowphase( std::vector<Body>& bodies, const std::vector<CollisionPair>& pairs, const float dt, const ContactMode mode, PairCaches& caches, std::vector<Contact>& contacts )
+{
+	caches.NextStep();
+
+	//  each shapes pair runs its own test over a homogeneous batch
+	std::vector<CollisionPair> shape_pairs[SHAPE_PAIRS_NUM];
+	SortPairsByShapes( bodies, pairs, shape_pairs );
+
+	for ( int type_a = 0; type_a < SHAPE_TYPES_NUM; type_a++ )
+	{
+		for ( int type_b = 0; type_b < SHAPE_TYPES_NUM; type_b++ )
+		{
+			const std::vector<CollisionPair>& batch = shape_pairs[type_a * SHAPE_TYPES_NUM + type_b];
+			if ( batch.empty() ) continue;
+
+			//  spheres get the SIMD path
+			if ( mode == ContactMode::TimeOfImpact
+			  && type_a == (int) Shape::ShapeType::SHAPE_SPHERE 
+			  && type_b == (int) Shape::ShapeType::SHAPE_SPHERE )
+			{
+				SphereToSphereContacts( bodies, batch, dt, contacts );
+				continue;
+			}
+
+			const Intersection::IntersectFunction intersect = mode == ContactMode::Speculative
+				? Intersection::GetSpeculativeFunction( (Shape::ShapeType) type_a, (Shape::ShapeType) type_b )
+				: Intersection::GetIntersectFunction( (Shape::ShapeType) type_a, (Shape::ShapeType) type_b );
+			for ( const CollisionPair& pair : batch )
+			{
+				Body& a = bodies[pair.a];
+				Body& b = bodies[pair.b];
+
+				PairCache& cache = caches.Get( pair.a, pair.b );
+
+				Contact contact;
+				if ( !intersect( a, b, dt, &cache, contact ) )
+				{
+					cache.manifold.Clear();
+					continue;
+				}
+
+				contact.bodyA = &a;
+				contact.bodyB = &b;
+
+				cache.manifold.RemoveExpiredPoints( a, b );
+				cache.manifold.AddContact( contact );
+				contacts.push_back( contact );
+
+				//  resting pairs also get the points of the previous steps
+				if ( contact.impactTime == 0.0f )
+				{
+					cache.manifold.GetPersistentContacts( a, b, contact, contacts );
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "Body.h"
+#include "Broadphase.h"
+#include "Contact.h"
+#include "Manifold.h"
+#include "Shape.h"
+
+const int SHAPE_TYPES_NUM = (int) Shape::ShapeType::SHAPE_NUM;
+const int SHAPE_PAIRS_NUM = SHAPE_TYPES_NUM * SHAPE_TYPES_NUM;
+
+//  data of a pair kept from one step to the next
+struct PairCache
+{
+	Vec3 separatingAxis { 0.0f };	//  last GJK search direction
+	Manifold manifold;
+	int lastStep = 0;
+};
+
+class PairCaches
+{
+public:
+	//  cache of the pair, created on first use
+	PairCache& Get( int id_a, int id_b );
+	//  forget the pairs which weren't used during the last step
+	void NextStep();
+
+private:
+	std::unordered_map<unsigned long long, PairCache> caches;
+	int step = 0;
+};
+
+//  sphere pairs gathered as structure of arrays, padded to the SIMD width
+struct SpherePairs
+{
+	int count = 0;
+	std::vector<int> a;
+	std::vector<int> b;
+
+	std::vector<float> positionA[3];
+	std::vector<float> velocityA[3];
+	std::vector<float> radiusA;
+	std::vector<float> positionB[3];
+	std::vector<float> velocityB[3];
+	std::vector<float> radiusB;
+
+	void Add( int id_a, int id_b, const Body& body_a, const Body& body_b, float radius_a, float radius_b );
+	void Pad();
+};
+
+struct SphereHit
+{
+	int pair;	//  index in SpherePairs
+	float impactTime;
+	float separationDistance;
+	Vec3 normal;
+	Vec3 pointA;
+	Vec3 pointB;
+};
+
+//  Intersection::DynamicSphereToSphere for SIMD_WIDTH pairs at once, hits are compacted in pairs order
+void SphereToSphereHits(
+	const SpherePairs& pairs,
+	const float dt,
+	std::vector<SphereHit>& hits
+);
+
+//  runs SphereToSphereHits and Intersection::DynamicSphereToSphere on random pairs,
+//  returns how many pairs don't give the same hit
+int CheckSphereToSphereHits( const int pairs_count, const float dt, const unsigned int seed );
+
+//  bucket candidate pairs by shapes pair, static pairs are dropped
+void SortPairsByShapes(
+	const std::vector<Body>& bodies,
+	const std::vector<CollisionPair>& pairs,
+	std::vector<CollisionPair> ( &shape_pairs )[SHAPE_PAIRS_NUM]
+);
+
+void SphereToSphereContacts(
+	std::vector<Body>& bodies,
+	const std::vector<CollisionPair>& pairs,
+	const float dt,
+	std::vector<Contact>& contacts
+);
+
+void Narrowphase(
+	std::vector<Body>& bodies,
+	const std::vector<CollisionPair>& pairs,
+	const float dt,
+	const ContactMode mode,
+	PairCaches& caches,
+	std::vector<Contact>& contacts
+);
@@ -0,0 +1,196 @@
+//
+//  PhysicsThread.cpp
+//
+#include "PhysicsThread.h"
+#include "Scene.h"
+#include "application.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+/*
+====================================================
+PhysicsThread::Start
+====================================================
+*/
+void PhysicsThread::Start( Application* application, Scene* scene )
+{
+	this->application = application;
+	this->scene = scene;
+
+	lastTransforms.clear();
+	Publish();
+
+	isRunning = true;
+	thread = std::thread( &PhysicsThread::Run, this );
+}
+
+/*
+====================================================
+PhysicsThread::Stop
+====================================================
+*/
+void PhysicsThread::Stop()
+{
+	if ( !isRunning ) return;
+
+	isRunning = false;
+	thread.join();
+}
+
+void PhysicsThread::PushInput( const InputEvent& event )
+{
+	std::lock_guard<std::mutex> lock( inputMutex );
+	inputEvents.push_back( event );
+}
+
+void PhysicsThread::SetCamera( const Camera& camera )
+{
+	std::lock_guard<std::mutex> lock( inputMutex );
+	this->camera = camera;
+	hasCamera = true;
+}
+
+/*
+====================================================
+PhysicsThread::Run
+
+Same clock as a fixed timestep game loop: elapsed time is
+accumulated and consumed by whole PHYSICS_DT steps, then the
+thread sleeps until the next one is due.
+====================================================
+*/
+void PhysicsThread::Run()
+{
+	float accumulator = 0.0f;
+	int last_time = GetTimeMicroseconds();
+
+	int samples_count = 0;
+	float average_time = 0.0f;
+	float max_time = 0.0f;
+
+	while ( isRunning )
+	{
+		const int time = GetTimeMicroseconds();
+		const float dt_sec = ( time - last_time ) * 0.001f * 0.001f;
+		last_time = time;
+
+		int requested_steps = 0;
+		ProcessInputs( requested_steps );
+
+		int steps_count = 0;
+		if ( application->IsPaused() )
+		{
+			accumulator = 0.0f;
+			steps_count = requested_steps;
+			samples_count = 0;
+			max_time = 0.0f;
+		}
+		else
+		{
+			accumulator += dt_sec;
+			while ( accumulator >= PHYSICS_DT && steps_count < MAX_PHYSICS_STEPS_PER_FRAME )
+			{
+				accumulator -= PHYSICS_DT;
+				steps_count++;
+			}
+
+			//  too far behind to catch up, drop the late time
+			if ( accumulator >= PHYSICS_DT )
+			{
+				accumulator = fmodf( accumulator, PHYSICS_DT );
+			}
+		}
+
+		if ( steps_count > 0 )
+		{
+			const int start_time = GetTimeMicroseconds();
+			for ( int i = 0; i < steps_count; i++ )
+			{
+				Step();
+			}
+			const float step_time = (float) ( GetTimeMicroseconds() - start_time ) / steps_count;
+
+			max_time = std::max( max_time, step_time );
+			average_time = ( average_time * float( samples_count ) + step_time ) / float( samples_count + 1 );
+			samples_count++;
+
+			//printf( "step dt_ms: %.2f %.2f %.2f\n", average_time * 0.001f, max_time * 0.001f, step_time * 0.001f );
+		}
+
+		//  sleep until the next step is due
+		const float time_to_next_step = PHYSICS_DT - accumulator;
+		std::this_thread::sleep_for( std::chrono::microseconds( (int) ( time_to_next_step * 1000.0f * 1000.0f ) ) );
+	}
+}
+
+void PhysicsThread::ProcessInputs( int& steps_count )
+{
+	std::vector<InputEvent> events;
+	{
+		std::lock_guard<std::mutex> lock( inputMutex );
+		events.swap( inputEvents );
+
+		if ( hasCamera )
+		{
+			//  the focus point belongs to the scene, it follows the target
+			Camera& scene_camera = scene->GetCamera();
+			scene_camera.PositionTheta = camera.PositionTheta;
+			scene_camera.PositionPhi = camera.PositionPhi;
+			scene_camera.Radius = camera.Radius;
+		}
+	}
+
+	for ( const InputEvent& event : events )
+	{
+		switch ( event.type )
+		{
+			case InputEventType::Key:
+				scene->OnKeyInput( event.key, event.action );
+				break;
+			case InputEventType::Reset:
+				scene->Reset();
+
+				//  nothing to interpolate from
+				lastTransforms.clear();
+				Publish();
+				break;
+			case InputEventType::Step:
+				steps_count++;
+				break;
+		}
+	}
+}
+
+void PhysicsThread::Step()
+{
+	scene->Update( PHYSICS_DT );
+
+	for ( int i = 0; i < PHYSICS_SUBSTEPS; i++ )
+	{
+		scene->UpdatePhysics( PHYSICS_DT / PHYSICS_SUBSTEPS );
+	}
+
+	Publish();
+}
+
+void PhysicsThread::Publish()
+{
+	TransformSnapshot& snapshot = snapshots.GetBack();
+
+	const int count = (int) scene->bodies.size();
+	snapshot.current.resize( count );
+	for ( int i = 0; i < count; i++ )
+	{
+		snapshot.current[i].position = scene->bodies[i].position;
+		snapshot.current[i].orientation = scene->bodies[i].orientation;
+	}
+
+	snapshot.previous = lastTransforms.size() == snapshot.current.size() ? lastTransforms : snapshot.current;
+	snapshot.focusPoint = scene->GetCamera().FocusPoint;
+	snapshot.stepTime = GetTimeMicroseconds();
+	lastTransforms = snapshot.current;
+
+	snapshots.Publish();
+}
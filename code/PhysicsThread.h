@@ -0,0 +1,100 @@
+//
+//  PhysicsThread.h
+//
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Camera.h"
+#include "Math/Quat.h"
+#include "TripleBuffer.h"
+
+class Application;
+class Scene;
+
+struct BodyTransform
+{
+	Vec3 position;
+	Quat orientation;
+};
+
+/*
+====================================================
+TransformSnapshot
+
+State of the bodies published after a physics step,
+never written again once published.
+====================================================
+*/
+struct TransformSnapshot
+{
+	std::vector<BodyTransform> previous;	//  before the last step, same as current after a reset
+	std::vector<BodyTransform> current;
+	Vec3 focusPoint;						//  camera focus set by the scene
+	int stepTime = 0;						//  GetTimeMicroseconds of the publication
+};
+
+enum class InputEventType
+{
+	Key,
+	Reset,
+	Step,	//  single step while paused
+};
+
+struct InputEvent
+{
+	InputEventType type;
+	int key = 0;
+	int action = 0;
+};
+
+/*
+====================================================
+PhysicsThread
+
+Runs the scene, game logic included, at a fixed rate on
+its own thread. The main thread never touches the scene
+once started: inputs are queued, the camera view is copied
+in, and transforms come back through a triple buffer.
+====================================================
+*/
+class PhysicsThread
+{
+public:
+	static constexpr float PHYSICS_DT = 1.0f / 60.0f;
+	static const int PHYSICS_SUBSTEPS = 2;				//  UpdatePhysics calls per physics step
+	static const int MAX_PHYSICS_STEPS_PER_FRAME = 4;	//  late time past this is dropped, so slow steps can't snowball
+
+	~PhysicsThread() { Stop(); }
+
+	//  publishes a first snapshot before returning
+	void Start( Application* application, Scene* scene );
+	void Stop();
+
+	//  main thread side
+	void PushInput( const InputEvent& event );
+	void SetCamera( const Camera& camera );
+	const TransformSnapshot& AcquireSnapshot() { return snapshots.Acquire(); }
+
+private:
+	void Run();
+	void ProcessInputs( int& steps_count );
+	void Step();
+	void Publish();
+
+	Application* application { nullptr };
+	Scene* scene { nullptr };
+
+	std::thread thread;
+	std::atomic<bool> isRunning { false };
+
+	std::mutex inputMutex;
+	std::vector<InputEvent> inputEvents;
+	Camera camera;							//  view of the main thread, only its angles & radius are used
+	bool hasCamera { false };
+
+	TripleBuffer<TransformSnapshot> snapshots;
+	std::vector<BodyTransform> lastTransforms;	//  current transforms of the last publication
+};
@@ -2,6 +2,7 @@
 //  Buffer.cpp
 //
 #include "Buffer.h"
+#include "StagingBuffer.h"
 #include <assert.h>
 #include <string.h>
 
@@ -20,6 +21,8 @@ Buffer::Buffer
 */
 Buffer::Buffer() :
 	m_vkBufferSize( 0 ) {
+	m_memory.memory = VK_NULL_HANDLE;
+	m_memory.mapped = NULL;
 }
 
 /*
@@ -28,6 +31,40 @@ Buffer::Allocate
 ====================================================
 */
 bool Buffer::Allocate( DeviceContext * device, const void * data, int size, VkBufferUsageFlagBits usageFlags ) {
+	if ( !Create( device, size, usageFlags, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT ) ) {
+		return false;
+	}
+
+	if ( NULL != data ) {
+		void * memory = MapBuffer( device );
+		memcpy( memory, data, size );
+		UnmapBuffer( device );
+	}
+	return true;
+}
+
+/*
+====================================================
+Buffer::AllocateStatic
+====================================================
+*/
+bool Buffer::AllocateStatic( DeviceContext * device, const void * data, int size, VkBufferUsageFlagBits usageFlags ) {
+	if ( !Create( device, size, usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT ) ) {
+		return false;
+	}
+
+	if ( NULL != data ) {
+		device->m_stagingBuffer->Upload( device, this, data, size );
+	}
+	return true;
+}
+
+/*
+====================================================
+Buffer::Create
+====================================================
+*/
+bool Buffer::Create( DeviceContext * device, int size, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryFlags ) {
 	VkResult result;
 
 	m_vkBufferSize = size;
@@ -48,27 +85,15 @@ bool Buffer::Allocate( DeviceContext * device, const void * data, int size, VkBu
 	VkMemoryRequirements memRequirements;
 	vkGetBufferMemoryRequirements( device->m_vkDevice, m_vkBuffer, &memRequirements );
 
-	m_vkMemoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT ;
+	m_vkMemoryPropertyFlags = memoryFlags;
 
-	VkMemoryAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = device->FindMemoryTypeIndex( memRequirements.memoryTypeBits, m_vkMemoryPropertyFlags );
-
-	result = vkAllocateMemory( device->m_vkDevice, &allocInfo, nullptr, &m_vkBufferMemory );
-	if ( VK_SUCCESS != result ) {
+	if ( !device->m_memoryAllocator->Allocate( device, memRequirements, m_vkMemoryPropertyFlags, true, m_memory ) ) {
 		printf( "ERROR: Failed to allocate buffer memory\n" );
 		assert( 0 );
 		return false;
 	}
 
-	if ( NULL != data ) {
-		void * memory = MapBuffer( device );
-		memcpy( memory, data, size );
-		UnmapBuffer( device );
-	}
-
-	vkBindBufferMemory( device->m_vkDevice, m_vkBuffer, m_vkBufferMemory, 0 );
+	vkBindBufferMemory( device->m_vkDevice, m_vkBuffer, m_memory.memory, m_memory.offset );
 	return true;
 }
 
@@ -79,7 +104,7 @@ Buffer::Cleanup
 */
 void Buffer::Cleanup( DeviceContext * device ) {
 	vkDestroyBuffer( device->m_vkDevice, m_vkBuffer, nullptr );
-	vkFreeMemory( device->m_vkDevice, m_vkBufferMemory, nullptr );
+	device->m_memoryAllocator->Free( device, m_memory );
 }
 
 /*
@@ -88,10 +113,9 @@ Buffer::MapBuffer
 ====================================================
 */
 void * Buffer::MapBuffer( DeviceContext * device ) {
-	void * mapped_ptr = NULL;
-	uint32_t byteOffset = 0;
-	vkMapMemory( device->m_vkDevice, m_vkBufferMemory, byteOffset, m_vkBufferSize, 0, &mapped_ptr );
-	return mapped_ptr;
+	// Host visible blocks are kept mapped by the allocator
+	assert( NULL != m_memory.mapped );
+	return m_memory.mapped;
 }
 
 /*
@@ -100,5 +124,5 @@ Buffer::UnmapBuffer
 ====================================================
 */
 void Buffer::UnmapBuffer( DeviceContext * device ) {
-	vkUnmapMemory( device->m_vkDevice, m_vkBufferMemory );
+	// The block stays mapped until it's released
 }
\ No newline at end of file
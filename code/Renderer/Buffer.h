@@ -3,6 +3,7 @@
 //
 #pragma once
 #include "DeviceContext.h"
+#include "MemoryAllocator.h"
 
 /*
 ================================================================================================
@@ -19,12 +20,19 @@ public:
 	Buffer();
 
 	bool Allocate( DeviceContext * device, const void * data, int size, VkBufferUsageFlagBits usageFlags );
+
+	// Device local memory for data that never changes, filled through the
+	// device's staging buffer, so it is only there after the next FlushUploads
+	bool AllocateStatic( DeviceContext * device, const void * data, int size, VkBufferUsageFlagBits usageFlags );
 	void Cleanup( DeviceContext * device );
 	void * MapBuffer( DeviceContext * device );
 	void UnmapBuffer( DeviceContext * device );
 
 	VkBuffer		m_vkBuffer;
-	VkDeviceMemory	m_vkBufferMemory;
+	MemoryAllocation_t m_memory;	// sub-allocated from the device's MemoryAllocator
 	VkDeviceSize	m_vkBufferSize;
 	VkMemoryPropertyFlags m_vkMemoryPropertyFlags;
+
+private:
+	bool Create( DeviceContext * device, int size, VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryFlags );
 };
\ No newline at end of file
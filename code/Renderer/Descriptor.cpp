@@ -29,36 +29,41 @@ bool Descriptors::Create( DeviceContext * device, const CreateParms_t & parms )
 	m_parms = parms;
 
 	//
-	//	Create the non-global pool
+	//	Size of the pools, they are only created once a frame needs them
 	//
-	std::vector< VkDescriptorPoolSize > poolSizes;
+	m_poolSizes.clear();
 	const int numUniforms = parms.numUniformsFragment + parms.numUniformsVertex;
-	if ( numUniforms > 0 ) {
+	int numDynamicUniforms = 0;
+	for ( int i = 0; i < parms.numUniformsVertex; i++ ) {
+		if ( IsDynamicUniform( i ) ) {
+			numDynamicUniforms++;
+		}
+	}
+	if ( numUniforms - numDynamicUniforms > 0 ) {
 		VkDescriptorPoolSize poolSize;
 		poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSize.descriptorCount = numUniforms * MAX_DESCRIPTOR_SETS;
-		poolSizes.push_back( poolSize );
+		poolSize.descriptorCount = ( numUniforms - numDynamicUniforms ) * SETS_PER_POOL;
+		m_poolSizes.push_back( poolSize );
+	}
+	if ( numDynamicUniforms > 0 ) {
+		VkDescriptorPoolSize poolSize;
+		poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		poolSize.descriptorCount = numDynamicUniforms * SETS_PER_POOL;
+		m_poolSizes.push_back( poolSize );
 	}
 	if ( parms.numImageSamplers > 0 ) {
 		VkDescriptorPoolSize poolSize;
 		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		poolSize.descriptorCount = parms.numImageSamplers * MAX_DESCRIPTOR_SETS;
-		poolSizes.push_back( poolSize );
+		poolSize.descriptorCount = parms.numImageSamplers * SETS_PER_POOL;
+		m_poolSizes.push_back( poolSize );
 	}
 
-	VkDescriptorPoolCreateInfo poolInfo = {};
-	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	poolInfo.poolSizeCount = (uint32_t)poolSizes.size();
-	poolInfo.pPoolSizes = poolSizes.data();
-	poolInfo.maxSets = MAX_DESCRIPTOR_SETS;
-	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-
-	result = vkCreateDescriptorPool( device->m_vkDevice, &poolInfo, nullptr, &m_vkDescriptorPool );
-	if ( VK_SUCCESS != result ) {
-		printf( "ERROR: Failed to create descriptor pool\n" );
-		assert( 0 );
-		return false;
+	m_frames.resize( DeviceContext::MAX_FRAMES_IN_FLIGHT );
+	for ( int i = 0; i < (int)m_frames.size(); i++ ) {
+		m_frames[ i ].currentPool = 0;
+		m_frames[ i ].numSetsInPool = 0;
 	}
+	m_frameIndex = 0;
 
 	//
 	// Create Descriptor Set Layout
@@ -72,7 +77,7 @@ bool Descriptors::Create( DeviceContext * device, const CreateParms_t & parms )
 	for ( int i = 0; i < parms.numUniformsVertex; i++ ) {
 		uniformBindings[ idx ].binding = idx;
 		uniformBindings[ idx ].descriptorCount = 1;
-		uniformBindings[ idx ].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uniformBindings[ idx ].descriptorType = IsDynamicUniform( i ) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		uniformBindings[ idx ].pImmutableSamplers = nullptr;
 		uniformBindings[ idx ].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
@@ -101,43 +106,124 @@ bool Descriptors::Create( DeviceContext * device, const CreateParms_t & parms )
 		return false;
 	}
 
-	//
-	//	Create Descriptor Sets
-	//
-	VkDescriptorSetLayout layouts[ MAX_DESCRIPTOR_SETS ];
-	for ( int i = 0; i < MAX_DESCRIPTOR_SETS; i++ ) {
-		layouts[ i ] = m_vkDescriptorSetLayout;
+	return true;
+}
+
+/*
+====================================================
+Descriptors::Cleanup
+====================================================
+*/
+void Descriptors::Cleanup( DeviceContext * device ) {
+	// Destroying the pools frees their descriptor sets
+	for ( int i = 0; i < (int)m_frames.size(); i++ ) {
+		FramePools_t & frame = m_frames[ i ];
+		for ( int j = 0; j < (int)frame.pools.size(); j++ ) {
+			vkDestroyDescriptorPool( device->m_vkDevice, frame.pools[ j ], nullptr );
+		}
 	}
+	m_frames.clear();
+
+	// Destroy descriptor set layout
+	vkDestroyDescriptorSetLayout( device->m_vkDevice, m_vkDescriptorSetLayout, nullptr );
+}
+
+/*
+====================================================
+Descriptors::BeginFrame
+====================================================
+*/
+void Descriptors::BeginFrame( DeviceContext * device ) {
+	m_frameIndex = device->m_frameIndex % DeviceContext::MAX_FRAMES_IN_FLIGHT;
+
+	FramePools_t & frame = m_frames[ m_frameIndex ];
+	for ( int i = 0; i < (int)frame.pools.size(); i++ ) {
+		vkResetDescriptorPool( device->m_vkDevice, frame.pools[ i ], 0 );
+	}
+	frame.currentPool = 0;
+	frame.numSetsInPool = 0;
+	frame.writtenSets.clear();
+	frame.writtenSetIds.clear();
+}
+
+/*
+====================================================
+Descriptors::GetFreeDescriptor
+
+The set itself is only picked once the bindings are known
+====================================================
+*/
+Descriptor Descriptors::GetFreeDescriptor() {
+	Descriptor descriptor;
+	descriptor.m_parent = this;
+	return descriptor;
+}
+
+/*
+====================================================
+Descriptors::AllocateDescriptorSet
+====================================================
+*/
+VkDescriptorSet Descriptors::AllocateDescriptorSet( DeviceContext * device ) {
+	VkResult result;
+
+	FramePools_t & frame = m_frames[ m_frameIndex ];
+	if ( frame.numSetsInPool >= SETS_PER_POOL ) {
+		frame.currentPool++;
+		frame.numSetsInPool = 0;
+	}
+
+	// Out of pools, the frame needs one more from now on
+	if ( frame.currentPool >= (int)frame.pools.size() ) {
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = (uint32_t)m_poolSizes.size();
+		poolInfo.pPoolSizes = m_poolSizes.data();
+		poolInfo.maxSets = SETS_PER_POOL;
+
+		VkDescriptorPool pool;
+		result = vkCreateDescriptorPool( device->m_vkDevice, &poolInfo, nullptr, &pool );
+		if ( VK_SUCCESS != result ) {
+			printf( "ERROR: Failed to create descriptor pool\n" );
+			assert( 0 );
+			return VK_NULL_HANDLE;
+		}
+		frame.pools.push_back( pool );
+	}
+
 	VkDescriptorSetAllocateInfo allocInfo = {};
 	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	allocInfo.descriptorPool = m_vkDescriptorPool;
-	allocInfo.descriptorSetCount = MAX_DESCRIPTOR_SETS;
-	allocInfo.pSetLayouts = layouts;
+	allocInfo.descriptorPool = frame.pools[ frame.currentPool ];
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &m_vkDescriptorSetLayout;
 
-	result = vkAllocateDescriptorSets( device->m_vkDevice, &allocInfo, m_vkDescriptorSets );
+	VkDescriptorSet descriptorSet;
+	result = vkAllocateDescriptorSets( device->m_vkDevice, &allocInfo, &descriptorSet );
 	if ( VK_SUCCESS != result ) {
 		printf( "ERROR: Failed to allocate descriptor set\n" );
 		assert( 0 );
-		return false;
+		return VK_NULL_HANDLE;
 	}
-
-	return true;
+	frame.numSetsInPool++;
+	return descriptorSet;
 }
 
 /*
 ====================================================
-Descriptors::Create
+Descriptors::FindWrittenSet
 ====================================================
 */
-void Descriptors::Cleanup( DeviceContext * device ) {
-	// Free the descriptor sets
-	vkFreeDescriptorSets( device->m_vkDevice, m_vkDescriptorPool, MAX_DESCRIPTOR_SETS, m_vkDescriptorSets );
-
-	// Destroy descriptor set layout
-	vkDestroyDescriptorSetLayout( device->m_vkDevice, m_vkDescriptorSetLayout, nullptr );
-
-	// Destroy Descriptor Pool
-	vkDestroyDescriptorPool( device->m_vkDevice, m_vkDescriptorPool, nullptr );
+VkDescriptorSet Descriptors::FindWrittenSet( const Descriptor & descriptor, const uint64_t hash ) const {
+	const FramePools_t & frame = m_frames[ m_frameIndex ];
+
+	auto range = frame.writtenSetIds.equal_range( hash );
+	for ( auto it = range.first; it != range.second; ++it ) {
+		const Descriptor & writtenSet = frame.writtenSets[ it->second ];
+		if ( writtenSet.HasSameWrites( descriptor ) ) {
+			return writtenSet.m_vkDescriptorSet;
+		}
+	}
+	return VK_NULL_HANDLE;
 }
 
 
@@ -160,7 +246,7 @@ Descriptor::Descriptor
 */
 Descriptor::Descriptor() {
 	m_parent = NULL;
-	m_id = -1;
+	m_vkDescriptorSet = VK_NULL_HANDLE;
 	m_numImages = 0;
 	m_numBuffers = 0;
 	memset( m_imageInfo, 0, sizeof( VkDescriptorImageInfo ) * MAX_IMAGEINFO );
@@ -201,6 +287,28 @@ Descriptor::BindDescriptor
 ====================================================
 */
 void Descriptor::BindDescriptor( DeviceContext * device, VkCommandBuffer vkCommandBuffer, Pipeline * pso ) {
+	UpdateDescriptor( device );
+	BindDescriptor( vkCommandBuffer, pso, nullptr, 0 );
+}
+
+/*
+====================================================
+Descriptor::UpdateDescriptor
+====================================================
+*/
+void Descriptor::UpdateDescriptor( DeviceContext * device ) {
+	// Same bindings as an earlier set of the frame, nothing to write
+	const uint64_t hash = GetWritesHash();
+	m_vkDescriptorSet = m_parent->FindWrittenSet( *this, hash );
+	if ( VK_NULL_HANDLE != m_vkDescriptorSet ) {
+		return;
+	}
+
+	m_vkDescriptorSet = m_parent->AllocateDescriptorSet( device );
+	if ( VK_NULL_HANDLE == m_vkDescriptorSet ) {
+		return;
+	}
+
 	const int numDescriptors = m_numImages + m_numBuffers;
 	const int allocationSize = sizeof( VkWriteDescriptorSet ) * numDescriptors;
 	VkWriteDescriptorSet * descriptorWrites = (VkWriteDescriptorSet *)alloca( allocationSize );
@@ -209,10 +317,10 @@ void Descriptor::BindDescriptor( DeviceContext * device, VkCommandBuffer vkComma
 	int idx = 0;
 	for ( int i = 0; i < m_numBuffers; i++ ) {
 		descriptorWrites[ idx ].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[ idx ].dstSet = m_parent->m_vkDescriptorSets[ m_id ];
+		descriptorWrites[ idx ].dstSet = m_vkDescriptorSet;
 		descriptorWrites[ idx ].dstBinding = idx;
 		descriptorWrites[ idx ].dstArrayElement = 0;
-		descriptorWrites[ idx ].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[ idx ].descriptorType = m_parent->IsDynamicUniform( i ) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		descriptorWrites[ idx ].descriptorCount = 1;
 		descriptorWrites[ idx ].pBufferInfo = &m_bufferInfo[ i ];
 
@@ -221,7 +329,7 @@ void Descriptor::BindDescriptor( DeviceContext * device, VkCommandBuffer vkComma
 
 	for ( int i = 0; i < m_numImages; i++ ) {
 		descriptorWrites[ idx ].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrites[ idx ].dstSet = m_parent->m_vkDescriptorSets[ m_id ];
+		descriptorWrites[ idx ].dstSet = m_vkDescriptorSet;
 		descriptorWrites[ idx ].dstBinding = idx;
 		descriptorWrites[ idx ].dstArrayElement = 0;
 		descriptorWrites[ idx ].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -232,5 +340,75 @@ void Descriptor::BindDescriptor( DeviceContext * device, VkCommandBuffer vkComma
 	}
 
 	vkUpdateDescriptorSets( device->m_vkDevice, (uint32_t)numDescriptors, descriptorWrites, 0, nullptr );
-	vkCmdBindDescriptorSets( vkCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pso->m_vkPipelineLayout, 0, 1, &m_parent->m_vkDescriptorSets[ m_id ], 0, nullptr );
+
+	Descriptors::FramePools_t & frame = m_parent->m_frames[ m_parent->m_frameIndex ];
+	frame.writtenSetIds.insert( std::make_pair( hash, (int)frame.writtenSets.size() ) );
+	frame.writtenSets.push_back( *this );
+}
+
+/*
+====================================================
+Descriptor::HasSameWrites
+====================================================
+*/
+bool Descriptor::HasSameWrites( const Descriptor & rhs ) const {
+	if ( m_numBuffers != rhs.m_numBuffers || m_numImages != rhs.m_numImages ) {
+		return false;
+	}
+
+	for ( int i = 0; i < m_numBuffers; i++ ) {
+		const VkDescriptorBufferInfo & a = m_bufferInfo[ i ];
+		const VkDescriptorBufferInfo & b = rhs.m_bufferInfo[ i ];
+		if ( a.buffer != b.buffer || a.offset != b.offset || a.range != b.range ) {
+			return false;
+		}
+	}
+
+	for ( int i = 0; i < m_numImages; i++ ) {
+		const VkDescriptorImageInfo & a = m_imageInfo[ i ];
+		const VkDescriptorImageInfo & b = rhs.m_imageInfo[ i ];
+		if ( a.imageLayout != b.imageLayout || a.imageView != b.imageView || a.sampler != b.sampler ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+====================================================
+Descriptor::GetWritesHash
+
+FNV-1a of the bound buffers and images
+====================================================
+*/
+static uint64_t HashValue( uint64_t hash, const uint64_t value ) {
+	for ( int i = 0; i < 8; i++ ) {
+		hash ^= ( value >> ( i * 8 ) ) & 0xff;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+uint64_t Descriptor::GetWritesHash() const {
+	uint64_t hash = 14695981039346656037ULL;
+	for ( int i = 0; i < m_numBuffers; i++ ) {
+		hash = HashValue( hash, (uint64_t)m_bufferInfo[ i ].buffer );
+		hash = HashValue( hash, (uint64_t)m_bufferInfo[ i ].offset );
+		hash = HashValue( hash, (uint64_t)m_bufferInfo[ i ].range );
+	}
+	for ( int i = 0; i < m_numImages; i++ ) {
+		hash = HashValue( hash, (uint64_t)m_imageInfo[ i ].imageView );
+		hash = HashValue( hash, (uint64_t)m_imageInfo[ i ].sampler );
+		hash = HashValue( hash, (uint64_t)m_imageInfo[ i ].imageLayout );
+	}
+	return hash;
+}
+
+/*
+====================================================
+Descriptor::BindDescriptor
+====================================================
+*/
+void Descriptor::BindDescriptor( VkCommandBuffer vkCommandBuffer, Pipeline * pso, const uint32_t * dynamicOffsets, const int numDynamicOffsets ) const {
+	vkCmdBindDescriptorSets( vkCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pso->m_vkPipelineLayout, 0, 1, &m_vkDescriptorSet, (uint32_t)numDynamicOffsets, dynamicOffsets );
 }
\ No newline at end of file
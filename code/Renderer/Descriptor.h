@@ -3,6 +3,9 @@
 //
 #pragma once
 #include <vulkan/vulkan.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
 
 class DeviceContext;
 class Buffer;
@@ -24,11 +27,20 @@ public:
 	void BindBuffer( Buffer * uniformBuffer, int offset, int size, int slot );
 	void BindDescriptor( DeviceContext * device, VkCommandBuffer vkCommandBuffer, Pipeline * pso );
 
+	// Split version of BindDescriptor, the set is written once then bound for many
+	// draws, each with its own offsets into the dynamic uniform buffers
+	void UpdateDescriptor( DeviceContext * device );
+	void BindDescriptor( VkCommandBuffer vkCommandBuffer, Pipeline * pso, const uint32_t * dynamicOffsets, const int numDynamicOffsets ) const;
+
 	friend class Descriptors;
 private:
 	Descriptors * m_parent;
 
-	int m_id;	// the id of the descriptor set to be used
+	// The descriptor set to be used, only picked by UpdateDescriptor
+	VkDescriptorSet m_vkDescriptorSet;
+
+	bool HasSameWrites( const Descriptor & rhs ) const;
+	uint64_t GetWritesHash() const;
 
 	int m_numBuffers;
 	static const int MAX_BUFFERS = 16;
@@ -42,11 +54,17 @@ private:
 /*
 ====================================================
 DescriptorSets
+
+The sets of a frame in flight are allocated from its own pools,
+a new pool is added whenever the frame runs out of sets. All the
+pools of a frame are reset at once when it comes back around.
+Identical writes within a frame share the same set.
+Not thread safe, the sets are written from the render thread only.
 ====================================================
 */
 class Descriptors {
 public:
-	Descriptors() : m_numDescriptorUsed( 0 ) {}
+	Descriptors() : m_frameIndex( 0 ) {}
 	~Descriptors() {}
 
 	// This structure creates the layout
@@ -54,27 +72,41 @@ public:
 		int numUniformsVertex;
 		int numUniformsFragment;
 		int numImageSamplers;
+		unsigned int dynamicUniformsMask;	// bit per vertex uniform slot, set for VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
 	};
 	CreateParms_t m_parms;
 
 	bool Create( DeviceContext * device, const CreateParms_t & parms );
 	void Cleanup( DeviceContext * device );
 
-	static const int MAX_DESCRIPTOR_SETS = 256;
+	bool IsDynamicUniform( const int slot ) const { return 0 != ( m_parms.dynamicUniformsMask & ( 1 << slot ) ); }
+
+	static const int SETS_PER_POOL = 128;
 
-	VkDescriptorPool m_vkDescriptorPool;
 	VkDescriptorSetLayout m_vkDescriptorSetLayout;
 
-	// The individual descriptor sets
-	int m_numDescriptorUsed;
-	VkDescriptorSet m_vkDescriptorSets[ MAX_DESCRIPTOR_SETS ];
+	// The fence of the frame has been waited for, so its sets can be recycled
+	void BeginFrame( DeviceContext * device );
+
+	Descriptor GetFreeDescriptor();
+
+private:
+	VkDescriptorSet AllocateDescriptorSet( DeviceContext * device );
+	VkDescriptorSet FindWrittenSet( const Descriptor & descriptor, const uint64_t hash ) const;
+
+	struct FramePools_t {
+		std::vector< VkDescriptorPool > pools;
+		int currentPool;
+		int numSetsInPool;	// sets allocated from the current pool
+
+		// Writes already done this frame, by hash
+		std::vector< Descriptor > writtenSets;
+		std::unordered_multimap< uint64_t, int > writtenSetIds;
+	};
 
+	std::vector< VkDescriptorPoolSize > m_poolSizes;
+	std::vector< FramePools_t > m_frames;	// one per frame in flight
+	int m_frameIndex;
 
-	Descriptor GetFreeDescriptor() {
-		Descriptor descriptor;
-		descriptor.m_parent = this;
-		descriptor.m_id = m_numDescriptorUsed % MAX_DESCRIPTOR_SETS;
-		m_numDescriptorUsed++;
-		return descriptor;
-	}
+	friend class Descriptor;
 };
\ No newline at end of file
@@ -3,6 +3,9 @@
 //
 #include "DeviceContext.h"
 #include "Fence.h"
+#include "StagingBuffer.h"
+#include "MemoryAllocator.h"
+#include "PipelineCache.h"
 #include <assert.h>
 
 /*
@@ -172,6 +175,8 @@ const std::vector< const char * > DeviceContext::m_deviceExtensions = {
 	VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME,
 };
 
+const char * DeviceContext::PIPELINE_CACHE_FILE = "data/pipeline.cache";
+
 /*
 ====================================================
 VulkanErrorMessage
@@ -272,6 +277,27 @@ DeviceContext::Cleanup
 void DeviceContext::Cleanup() {
 	m_swapChain.Cleanup( this );
 
+	// Staging buffer
+	if ( NULL != m_stagingBuffer ) {
+		m_stagingBuffer->Cleanup( this );
+		delete m_stagingBuffer;
+		m_stagingBuffer = NULL;
+	}
+
+	// Pipeline cache, written to disk before going away
+	if ( NULL != m_pipelineCache ) {
+		m_pipelineCache->Cleanup( this );
+		delete m_pipelineCache;
+		m_pipelineCache = NULL;
+	}
+
+	// Memory blocks
+	if ( NULL != m_memoryAllocator ) {
+		m_memoryAllocator->Cleanup( this );
+		delete m_memoryAllocator;
+		m_memoryAllocator = NULL;
+	}
+
 	// Destroy Command Buffers
 	vkFreeCommandBuffers( m_vkDevice, m_vkCommandPool, (uint32_t)m_vkCommandBuffers.size(), m_vkCommandBuffers.data() );
 	vkDestroyCommandPool( m_vkDevice, m_vkCommandPool, nullptr );
@@ -303,6 +329,15 @@ bool DeviceContext::CreateDevice() {
 		return false;
 	}
 
+	m_memoryAllocator = new MemoryAllocator;
+
+	m_pipelineCache = new PipelineCache;
+	if ( !m_pipelineCache->Create( this, PIPELINE_CACHE_FILE ) ) {
+		printf( "ERROR: Failed to create pipeline cache\n" );
+		assert( 0 );
+		return false;
+	}
+
 	return true;
 }
 
@@ -575,6 +610,16 @@ bool DeviceContext::CreateCommandBuffers() {
 		}
 	}
 
+	// Staging buffer, its copies are recorded into transient command buffers from the pool
+	{
+		m_stagingBuffer = new StagingBuffer;
+		if ( !m_stagingBuffer->Create( this ) ) {
+			printf( "ERROR: Failed to create staging buffer\n" );
+			assert( 0 );
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -637,6 +682,15 @@ void DeviceContext::FlushCommandBuffer( VkCommandBuffer commandBuffer, VkQueue q
 	vkFreeCommandBuffers( m_vkDevice, m_vkCommandPool, 1, &commandBuffer );
 }
 
+/*
+====================================================
+DeviceContext::FlushUploads
+====================================================
+*/
+void DeviceContext::FlushUploads() {
+	m_stagingBuffer->Flush( this );
+}
+
 /*
 ====================================================
 DeviceContext::GetAligendUniformByteOffset
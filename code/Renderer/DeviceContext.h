@@ -5,6 +5,10 @@
 #include "SwapChain.h"
 #include <vector>
 
+class StagingBuffer;
+class MemoryAllocator;
+class PipelineCache;
+
 /*
 ====================================================
 Vulkan Extension Functions
@@ -76,6 +80,13 @@ public:
 
 	uint32_t FindMemoryTypeIndex( uint32_t typeFilter, VkMemoryPropertyFlags properties );
 
+	// Buffers and images get their memory from here rather than from vkAllocateMemory
+	MemoryAllocator * m_memoryAllocator = NULL;
+
+	// Compiled pipelines, kept on disk between runs
+	PipelineCache * m_pipelineCache = NULL;
+	static const char * PIPELINE_CACHE_FILE;
+
 	static const std::vector< const char * > m_deviceExtensions;
 	std::vector< const char * > m_validationLayers;
 
@@ -90,6 +101,12 @@ public:
 	VkCommandBuffer CreateCommandBuffer( VkCommandBufferLevel level );
 	void FlushCommandBuffer( VkCommandBuffer commandBuffer, VkQueue queue );
 
+	//
+	//	Uploads to device local memory, batched until flushed
+	//
+	StagingBuffer * m_stagingBuffer = NULL;
+	void FlushUploads();
+
 	//
 	//	Swap chain related
 	//
@@ -97,8 +114,14 @@ public:
 	bool CreateSwapChain( int width, int height ) { return m_swapChain.Create( this, width, height ); }
 	void ResizeWindow( int width, int height ) { m_swapChain.Resize( this, width, height ); }
 
-	uint32_t BeginFrame() { return m_swapChain.BeginFrame( this ); }
-	void EndFrame() { m_swapChain.EndFrame( this ); }
+	uint32_t BeginFrame() { FlushUploads(); return m_swapChain.BeginFrame( this ); }
+	void EndFrame() { m_swapChain.EndFrame( this ); m_frameIndex = ( m_frameIndex + 1 ) % MAX_FRAMES_IN_FLIGHT; }
+
+	//
+	//	Frames in flight, transient data is kept per frame until the gpu is done with it
+	//
+	static const int MAX_FRAMES_IN_FLIGHT = 2;
+	int m_frameIndex = 0;	// advanced by EndFrame
 
 	void BeginRenderPass() { m_swapChain.BeginRenderPass( this ); }
 	void EndRenderPass() { m_swapChain.EndRenderPass( this ); }
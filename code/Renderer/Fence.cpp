@@ -2,6 +2,7 @@
 //  Fence.cpp
 //
 #include "Fence.h"
+#include "DeviceContext.h"
 #include <assert.h>
 #include <stdio.h>
 
@@ -18,10 +19,10 @@ Fence
 Fence::Create
 ====================================================
 */
-bool Fence::Create( DeviceContext * device ) {
+bool Fence::Create( DeviceContext * device, bool isSignaled ) {
 	VkFenceCreateInfo fenceCreateInfo {};
 	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCreateInfo.flags = 0;
+	fenceCreateInfo.flags = isSignaled ? VK_FENCE_CREATE_SIGNALED_BIT : 0;
 
 	VkResult result = vkCreateFence( device->m_vkDevice, &fenceCreateInfo, nullptr, &m_vkFence );
 	if ( VK_SUCCESS != result ) {
@@ -35,15 +36,21 @@ bool Fence::Create( DeviceContext * device ) {
 
 /*
 ====================================================
-Fence::Wait
+Fence::Cleanup
 ====================================================
 */
-bool Fence::Wait( DeviceContext * device ) {
-	uint64_t timeoutns = (uint64_t)1e9;
-	VkResult result = vkWaitForFences( device->m_vkDevice, 1, &m_vkFence, VK_TRUE, timeoutns );
-
+void Fence::Cleanup( DeviceContext * device ) {
 	vkDestroyFence( device->m_vkDevice, m_vkFence, nullptr );
+	m_vkFence = VK_NULL_HANDLE;
+}
 
+/*
+====================================================
+Fence::Wait
+====================================================
+*/
+bool Fence::Wait( DeviceContext * device, uint64_t timeoutns ) {
+	VkResult result = vkWaitForFences( device->m_vkDevice, 1, &m_vkFence, VK_TRUE, timeoutns );
 	if ( VK_SUCCESS != result ) {
 		printf( "failed to wait for fence\n" );
 		assert( 0 );
@@ -51,3 +58,12 @@ bool Fence::Wait( DeviceContext * device ) {
 	}
 	return true;
 }
+
+/*
+====================================================
+Fence::Reset
+====================================================
+*/
+void Fence::Reset( DeviceContext * device ) {
+	vkResetFences( device->m_vkDevice, 1, &m_vkFence );
+}
\ No newline at end of file
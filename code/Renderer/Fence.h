@@ -3,23 +3,38 @@
 //
 #pragma once
 #include <vulkan/vulkan.h>
-#include "DeviceContext.h"
+
+class DeviceContext;
 
 /*
 ====================================================
 Fence
+
+Built with a device, it is scoped: waited on and destroyed when
+it goes out of scope. Default built, it is kept around and its
+owner drives Create, Wait, Reset and Cleanup.
 ====================================================
 */
 class Fence {
 public:
+	Fence() : m_vkFence( VK_NULL_HANDLE ), m_device( NULL ) {}
 	Fence( DeviceContext * device ) { Create( device ); m_device = device; }
-	~Fence() { Wait( m_device ); }
+	~Fence() {
+		if ( NULL != m_device ) {
+			Wait( m_device );
+			Cleanup( m_device );
+		}
+	}
+
+	bool Create( DeviceContext * device, bool isSignaled = false );
+	void Cleanup( DeviceContext * device );
+
+	// Scoped fences wait for short uploads, per frame fences wait without a timeout
+	bool Wait( DeviceContext * device, uint64_t timeoutns = 1000000000ull );
+	void Reset( DeviceContext * device );
 
 	VkFence m_vkFence;
 
 private:
-	bool Create( DeviceContext * device );
-	bool Wait( DeviceContext * device );
-
-	DeviceContext * m_device;
-};
\ No newline at end of file
+	DeviceContext * m_device;	// set for scoped fences only
+};
@@ -74,6 +74,7 @@ bool FrameBuffer::Create( DeviceContext * device, CreateParms_t & parms ) {
 		parmsImage.depth = 1;
 		parmsImage.format = DEPTH_FORMAT;
 		parmsImage.usageFlags = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		parmsImage.usageFlags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;	// depth can be cached with copies
 		if ( !m_imageDepth.Create( device, parmsImage ) ) {
 			printf( "ERROR: Failed to create depth image\n" );
 			assert( 0 );
@@ -156,6 +157,11 @@ bool FrameBuffer::CreateRenderPass( DeviceContext * device ) {
 	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if ( m_parms.loadDepth ) {
+		// The image has to be in the attachment layout already for its content to be kept
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	}
 	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 	m_imageDepth.m_vkImageLayout = depthAttachment.finalLayout;
 
@@ -257,7 +263,7 @@ bool FrameBuffer::CreateRenderPass( DeviceContext * device ) {
 FrameBuffer::BeginRenderPass
 ====================================================
 */
-void FrameBuffer::BeginRenderPass( DeviceContext * device, const int cmdBufferIndex ) {
+void FrameBuffer::BeginRenderPass( DeviceContext * device, const int cmdBufferIndex, const VkSubpassContents contents ) {
 	VkRenderPassBeginInfo renderPassBeginInfo = {};
 	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 	renderPassBeginInfo.renderPass = m_vkRenderPass;
@@ -281,8 +287,19 @@ void FrameBuffer::BeginRenderPass( DeviceContext * device, const int cmdBufferIn
 	renderPassBeginInfo.clearValueCount = (uint32_t)clearValues.size();
 	renderPassBeginInfo.pClearValues = clearValues.data();
 
-	vkCmdBeginRenderPass( device->m_vkCommandBuffers[ cmdBufferIndex ], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE );
+	vkCmdBeginRenderPass( device->m_vkCommandBuffers[ cmdBufferIndex ], &renderPassBeginInfo, contents );
+
+	if ( VK_SUBPASS_CONTENTS_INLINE == contents ) {
+		SetDynamicState( device->m_vkCommandBuffers[ cmdBufferIndex ] );
+	}
+}
 
+/*
+====================================================
+FrameBuffer::SetDynamicState
+====================================================
+*/
+void FrameBuffer::SetDynamicState( VkCommandBuffer cmdBuffer ) {
 	VkViewport viewport = {};
 	viewport.x = 0.0f;
 	viewport.y = 0.0f;
@@ -290,14 +307,14 @@ void FrameBuffer::BeginRenderPass( DeviceContext * device, const int cmdBufferIn
 	viewport.height = (float)m_parms.height;
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
-	vkCmdSetViewport( device->m_vkCommandBuffers[ cmdBufferIndex ], 0, 1, &viewport );
+	vkCmdSetViewport( cmdBuffer, 0, 1, &viewport );
 
 	VkRect2D scissor = {};
 	scissor.offset.x = 0;
 	scissor.offset.y = 0;
 	scissor.extent.width = m_parms.width;
 	scissor.extent.height = m_parms.height;
-	vkCmdSetScissor( device->m_vkCommandBuffers[ cmdBufferIndex ], 0, 1, &scissor );
+	vkCmdSetScissor( cmdBuffer, 0, 1, &scissor );
 
 	//
 	//	If the frame buffer has no color attachment,
@@ -307,7 +324,7 @@ void FrameBuffer::BeginRenderPass( DeviceContext * device, const int cmdBufferIn
 	if ( m_parms.hasDepth && !m_parms.hasColor ) {
 		float bias = 1.25f;
 		float slope = 1.75f;
-		vkCmdSetDepthBias( device->m_vkCommandBuffers[ cmdBufferIndex ], bias, 0.0f, slope );
+		vkCmdSetDepthBias( cmdBuffer, bias, 0.0f, slope );
 	}
 }
 
@@ -22,12 +22,15 @@ public:
 		int height;
 		bool hasDepth;
 		bool hasColor;
+		bool loadDepth;	// the render pass starts from the depth already in the image instead of clearing it
 	};
 
 	bool Create( DeviceContext * device, CreateParms_t & parms );
 	void Cleanup( DeviceContext * device );
 
-	void BeginRenderPass( DeviceContext * device, const int cmdBufferIndex );
+	// Secondary contents are drawn by command buffers that set their own dynamic state
+	void BeginRenderPass( DeviceContext * device, const int cmdBufferIndex, const VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE );
+	void SetDynamicState( VkCommandBuffer cmdBuffer );
 	void EndRenderPass( DeviceContext * device, const int cmdBufferIndex );
 
 	CreateParms_t			m_parms;
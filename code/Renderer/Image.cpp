@@ -2,6 +2,7 @@
 //  Image.cpp
 //
 #include "Image.h"
+#include "MemoryAllocator.h"
 #include <assert.h>
 #include <stdio.h>
 
@@ -63,21 +64,17 @@ bool Image::Create( DeviceContext * device, const CreateParms_t & parms ) {
 	//	Allocate memory on the GPU and attach it to the 
 	//
 
-	VkMemoryAllocateInfo memAlloc = {};
-	memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 	VkMemoryRequirements memReqs;
 	vkGetImageMemoryRequirements( device->m_vkDevice, m_vkImage, &memReqs );
-	memAlloc.allocationSize = memReqs.size;
-	memAlloc.memoryTypeIndex = device->FindMemoryTypeIndex( memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
 
-	result = vkAllocateMemory( device->m_vkDevice, &memAlloc, nullptr, &m_vkDeviceMemory );
-	if ( VK_SUCCESS != result ) {
+	// Optimal tiling, so not linear
+	if ( !device->m_memoryAllocator->Allocate( device, memReqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, m_memory ) ) {
 		printf( "ERROR: Failed to allocate memory\n" );
 		assert( 0 );
 		return false;
 	}
 
-	result = vkBindImageMemory( device->m_vkDevice, m_vkImage, m_vkDeviceMemory, 0 );
+	result = vkBindImageMemory( device->m_vkDevice, m_vkImage, m_memory.memory, m_memory.offset );
 	if ( VK_SUCCESS != result ) {
 		printf( "ERROR: Failed to bind image memory\n" );
 		assert( 0 );
@@ -130,7 +127,7 @@ Image::Cleanup
 void Image::Cleanup( DeviceContext * device ) {
 	vkDestroyImageView( device->m_vkDevice, m_vkImageView, nullptr );
 	vkDestroyImage( device->m_vkDevice, m_vkImage, nullptr );
-	vkFreeMemory( device->m_vkDevice, m_vkDeviceMemory, nullptr );
+	device->m_memoryAllocator->Free( device, m_memory );
 }
 
 /*
@@ -208,11 +205,14 @@ void Image::TransitionLayout( VkCommandBuffer cmdBuffer, VkImageLayout newLayout
 	barrier.subresourceRange.levelCount = 1;
 	barrier.subresourceRange.baseArrayLayer = 0;
 	barrier.subresourceRange.layerCount = 1;
-	barrier.srcAccessMask = 0;
-	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 
-	VkPipelineStageFlags sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-	VkPipelineStageFlags destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;				
+	// Render targets are shared by the frames in flight, so the previous
+	// frame's use of the image must be finished, whatever it was
+	barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+	VkPipelineStageFlags sourceStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	VkPipelineStageFlags destinationStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 
 	vkCmdPipelineBarrier(
 		cmdBuffer,
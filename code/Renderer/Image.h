@@ -4,6 +4,7 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include "DeviceContext.h"
+#include "MemoryAllocator.h"
 
 /*
 ====================================================
@@ -31,7 +32,7 @@ public:
 	CreateParms_t	m_parms;
 	VkImage			m_vkImage;
 	VkImageView		m_vkImageView;
-	VkDeviceMemory	m_vkDeviceMemory;
+	MemoryAllocation_t m_memory;	// sub-allocated from the device's MemoryAllocator
 
 	VkImageLayout	m_vkImageLayout;
 };
\ No newline at end of file
@@ -0,0 +1,301 @@
+//
+//  MemoryAllocator.cpp
+//
+#include "MemoryAllocator.h"
+#include "DeviceContext.h"
+#include <assert.h>
+#include <stdio.h>
+
+/*
+================================================================================================
+
+MemoryAllocator
+
+================================================================================================
+*/
+
+/*
+====================================================
+MemoryAllocator::Cleanup
+====================================================
+*/
+void MemoryAllocator::Cleanup( DeviceContext * device ) {
+	for ( int p = 0; p < m_pools.size(); p++ ) {
+		pool_t & pool = m_pools[ p ];
+		for ( int b = 0; b < pool.blocks.size(); b++ ) {
+			block_t * block = pool.blocks[ b ];
+			if ( NULL == block ) {
+				continue;
+			}
+
+			if ( block->numAllocations > 0 ) {
+				printf( "WARNING: %i memory allocations leaked in block %i of memory type %u\n", block->numAllocations, b, pool.memoryTypeIndex );
+			}
+			if ( NULL != block->mapped ) {
+				vkUnmapMemory( device->m_vkDevice, block->memory );
+			}
+			vkFreeMemory( device->m_vkDevice, block->memory, nullptr );
+			delete block;
+		}
+	}
+	m_pools.clear();
+}
+
+/*
+====================================================
+MemoryAllocator::CreateBlock
+====================================================
+*/
+MemoryAllocator::block_t * MemoryAllocator::CreateBlock( DeviceContext * device, uint32_t memoryTypeIndex, VkDeviceSize size ) {
+	VkResult result;
+
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkDeviceMemory memory;
+	result = vkAllocateMemory( device->m_vkDevice, &allocInfo, nullptr, &memory );
+	if ( VK_SUCCESS != result ) {
+		printf( "ERROR: Failed to allocate memory block\n" );
+		assert( 0 );
+		return NULL;
+	}
+
+	block_t * block = new block_t;
+	block->memory = memory;
+	block->size = size;
+	block->mapped = NULL;
+	block->numAllocations = 0;
+
+	range_t range;
+	range.offset = 0;
+	range.size = size;
+	block->freeRanges.push_back( range );
+
+	// A memory object can only be mapped once, so host visible blocks stay mapped for their whole life
+	const VkPhysicalDeviceMemoryProperties & memProperties = device->m_physicalDevices[ device->m_deviceIndex ].m_vkMemoryProperties;
+	if ( memProperties.memoryTypes[ memoryTypeIndex ].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ) {
+		void * mapped = NULL;
+		vkMapMemory( device->m_vkDevice, memory, 0, VK_WHOLE_SIZE, 0, &mapped );
+		block->mapped = (unsigned char *)mapped;
+	}
+
+	return block;
+}
+
+/*
+====================================================
+MemoryAllocator::AllocateFromBlock
+====================================================
+*/
+bool MemoryAllocator::AllocateFromBlock( block_t * block, const VkMemoryRequirements & requirements, VkDeviceSize & offset ) {
+	const VkDeviceSize alignment = requirements.alignment > 0 ? requirements.alignment : 1;
+
+	for ( int i = 0; i < block->freeRanges.size(); i++ ) {
+		const range_t range = block->freeRanges[ i ];
+		const VkDeviceSize alignedOffset = ( ( range.offset + alignment - 1 ) / alignment ) * alignment;
+		const VkDeviceSize end = alignedOffset + requirements.size;
+		if ( end > range.offset + range.size ) {
+			continue;
+		}
+
+		// Split the range, the padding in front and the rest behind stay free
+		block->freeRanges.erase( block->freeRanges.begin() + i );
+		if ( end < range.offset + range.size ) {
+			range_t tail;
+			tail.offset = end;
+			tail.size = range.offset + range.size - end;
+			block->freeRanges.insert( block->freeRanges.begin() + i, tail );
+		}
+		if ( alignedOffset > range.offset ) {
+			range_t head;
+			head.offset = range.offset;
+			head.size = alignedOffset - range.offset;
+			block->freeRanges.insert( block->freeRanges.begin() + i, head );
+		}
+
+		block->numAllocations++;
+		offset = alignedOffset;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+====================================================
+MemoryAllocator::Allocate
+====================================================
+*/
+bool MemoryAllocator::Allocate( DeviceContext * device, const VkMemoryRequirements & requirements, VkMemoryPropertyFlags memoryFlags, bool isLinear, MemoryAllocation_t & allocation ) {
+	const uint32_t memoryTypeIndex = device->FindMemoryTypeIndex( requirements.memoryTypeBits, memoryFlags );
+
+	int poolIndex = -1;
+	for ( int p = 0; p < m_pools.size(); p++ ) {
+		if ( m_pools[ p ].memoryTypeIndex == memoryTypeIndex && m_pools[ p ].isLinear == isLinear ) {
+			poolIndex = p;
+			break;
+		}
+	}
+	if ( poolIndex < 0 ) {
+		pool_t pool;
+		pool.memoryTypeIndex = memoryTypeIndex;
+		pool.isLinear = isLinear;
+		m_pools.push_back( pool );
+		poolIndex = (int)m_pools.size() - 1;
+	}
+	pool_t & pool = m_pools[ poolIndex ];
+
+	VkDeviceSize offset = 0;
+	int blockIndex = -1;
+	for ( int b = 0; b < pool.blocks.size(); b++ ) {
+		if ( NULL != pool.blocks[ b ] && AllocateFromBlock( pool.blocks[ b ], requirements, offset ) ) {
+			blockIndex = b;
+			break;
+		}
+	}
+
+	if ( blockIndex < 0 ) {
+		// Resources bigger than a block get a block of their own
+		const VkDeviceSize blockSize = requirements.size > BLOCK_SIZE ? requirements.size : BLOCK_SIZE;
+		block_t * block = CreateBlock( device, memoryTypeIndex, blockSize );
+		if ( NULL == block ) {
+			return false;
+		}
+
+		// Reuse the slot of a released block
+		for ( int b = 0; b < pool.blocks.size(); b++ ) {
+			if ( NULL == pool.blocks[ b ] ) {
+				blockIndex = b;
+				break;
+			}
+		}
+		if ( blockIndex < 0 ) {
+			pool.blocks.push_back( NULL );
+			blockIndex = (int)pool.blocks.size() - 1;
+		}
+		pool.blocks[ blockIndex ] = block;
+
+		AllocateFromBlock( block, requirements, offset );
+	}
+
+	block_t * block = pool.blocks[ blockIndex ];
+	allocation.memory = block->memory;
+	allocation.offset = offset;
+	allocation.size = requirements.size;
+	allocation.mapped = ( NULL != block->mapped ) ? block->mapped + offset : NULL;
+	allocation.poolIndex = poolIndex;
+	allocation.blockIndex = blockIndex;
+	return true;
+}
+
+/*
+====================================================
+MemoryAllocator::Free
+====================================================
+*/
+void MemoryAllocator::Free( DeviceContext * device, MemoryAllocation_t & allocation ) {
+	if ( VK_NULL_HANDLE == allocation.memory ) {
+		return;
+	}
+
+	pool_t & pool = m_pools[ allocation.poolIndex ];
+	block_t * block = pool.blocks[ allocation.blockIndex ];
+
+	// Insert the range back in offset order, merging it with the free ranges it touches
+	range_t range;
+	range.offset = allocation.offset;
+	range.size = allocation.size;
+
+	int i = 0;
+	while ( i < block->freeRanges.size() && block->freeRanges[ i ].offset < range.offset ) {
+		i++;
+	}
+
+	if ( i > 0 && block->freeRanges[ i - 1 ].offset + block->freeRanges[ i - 1 ].size == range.offset ) {
+		i--;
+		range.offset = block->freeRanges[ i ].offset;
+		range.size += block->freeRanges[ i ].size;
+		block->freeRanges.erase( block->freeRanges.begin() + i );
+	}
+	if ( i < block->freeRanges.size() && range.offset + range.size == block->freeRanges[ i ].offset ) {
+		range.size += block->freeRanges[ i ].size;
+		block->freeRanges.erase( block->freeRanges.begin() + i );
+	}
+	block->freeRanges.insert( block->freeRanges.begin() + i, range );
+
+	block->numAllocations--;
+	allocation.memory = VK_NULL_HANDLE;
+	allocation.mapped = NULL;
+
+	// Standard blocks are kept for the next allocations, oversized ones go back to the device
+	if ( 0 == block->numAllocations && block->size > BLOCK_SIZE ) {
+		if ( NULL != block->mapped ) {
+			vkUnmapMemory( device->m_vkDevice, block->memory );
+		}
+		vkFreeMemory( device->m_vkDevice, block->memory, nullptr );
+		delete block;
+		pool.blocks[ allocation.blockIndex ] = NULL;
+	}
+}
+
+/*
+====================================================
+MemoryAllocator::GetStats
+====================================================
+*/
+MemoryAllocator::Stats_t MemoryAllocator::GetStats() const {
+	Stats_t stats = {};
+
+	VkDeviceSize freeBytes = 0;
+	VkDeviceSize contiguousFreeBytes = 0;	// sum of the largest free range of each block
+	for ( int p = 0; p < m_pools.size(); p++ ) {
+		const pool_t & pool = m_pools[ p ];
+		for ( int b = 0; b < pool.blocks.size(); b++ ) {
+			const block_t * block = pool.blocks[ b ];
+			if ( NULL == block ) {
+				continue;
+			}
+
+			stats.numBlocks++;
+			stats.numAllocations += block->numAllocations;
+			stats.numFreeRanges += (int)block->freeRanges.size();
+			stats.blockBytes += block->size;
+
+			VkDeviceSize largestInBlock = 0;
+			for ( int i = 0; i < block->freeRanges.size(); i++ ) {
+				const VkDeviceSize size = block->freeRanges[ i ].size;
+				freeBytes += size;
+				if ( size > largestInBlock ) {
+					largestInBlock = size;
+				}
+			}
+			contiguousFreeBytes += largestInBlock;
+			if ( largestInBlock > stats.largestFreeRange ) {
+				stats.largestFreeRange = largestInBlock;
+			}
+		}
+	}
+
+	stats.usedBytes = stats.blockBytes - freeBytes;
+	stats.fragmentation = ( freeBytes > 0 ) ? 1.0f - (float)contiguousFreeBytes / (float)freeBytes : 0.0f;
+	return stats;
+}
+
+/*
+====================================================
+MemoryAllocator::PrintStats
+====================================================
+*/
+void MemoryAllocator::PrintStats() const {
+	const Stats_t stats = GetStats();
+	printf( "Memory: %i allocations in %i blocks, %.2f / %.2f MiB used, %i free ranges, largest %.2f MiB, fragmentation %.2f\n",
+		stats.numAllocations,
+		stats.numBlocks,
+		(float)stats.usedBytes / ( 1024.0f * 1024.0f ),
+		(float)stats.blockBytes / ( 1024.0f * 1024.0f ),
+		stats.numFreeRanges,
+		(float)stats.largestFreeRange / ( 1024.0f * 1024.0f ),
+		stats.fragmentation );
+}
\ No newline at end of file
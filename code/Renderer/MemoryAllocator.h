@@ -0,0 +1,87 @@
+//
+//  MemoryAllocator.h
+//
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+
+class DeviceContext;
+
+/*
+====================================================
+MemoryAllocation_t
+====================================================
+*/
+struct MemoryAllocation_t {
+	VkDeviceMemory	memory;
+	VkDeviceSize	offset;		// where to bind the resource in memory
+	VkDeviceSize	size;
+	void *			mapped;		// persistently mapped if the memory is host visible, NULL otherwise
+	int				poolIndex;
+	int				blockIndex;
+};
+
+/*
+================================================================================================
+
+MemoryAllocator
+
+Sub-allocates buffers and images out of large VkDeviceMemory blocks, one
+pool of blocks per memory type. Each block keeps its free ranges sorted by
+offset, allocations take the first range that fits once aligned, and freed
+ranges are merged back with their neighbours.
+
+Linear resources (buffers) and optimal images get separate pools, so they
+never share a block and bufferImageGranularity never comes into play.
+
+================================================================================================
+*/
+class MemoryAllocator {
+public:
+	MemoryAllocator() {}
+	~MemoryAllocator() {}
+
+	static const VkDeviceSize BLOCK_SIZE = 32 * 1024 * 1024;
+
+	void Cleanup( DeviceContext * device );
+
+	bool Allocate( DeviceContext * device, const VkMemoryRequirements & requirements, VkMemoryPropertyFlags memoryFlags, bool isLinear, MemoryAllocation_t & allocation );
+	void Free( DeviceContext * device, MemoryAllocation_t & allocation );
+
+	struct Stats_t {
+		int				numBlocks;
+		int				numAllocations;
+		int				numFreeRanges;
+		VkDeviceSize	blockBytes;			// reserved from the device
+		VkDeviceSize	usedBytes;			// handed out, alignment padding included
+		VkDeviceSize	largestFreeRange;
+		float			fragmentation;		// 0 when the free space of each block is one range, close to 1 when it's scattered
+	};
+	Stats_t GetStats() const;
+	void PrintStats() const;
+
+private:
+	struct range_t {
+		VkDeviceSize offset;
+		VkDeviceSize size;
+	};
+
+	struct block_t {
+		VkDeviceMemory			memory;
+		VkDeviceSize			size;
+		unsigned char *			mapped;
+		std::vector< range_t >	freeRanges;	// sorted by offset, never adjacent
+		int						numAllocations;
+	};
+
+	struct pool_t {
+		uint32_t				memoryTypeIndex;
+		bool					isLinear;
+		std::vector< block_t * > blocks;	// NULL once a block has been released
+	};
+
+	block_t * CreateBlock( DeviceContext * device, uint32_t memoryTypeIndex, VkDeviceSize size );
+	static bool AllocateFromBlock( block_t * block, const VkMemoryRequirements & requirements, VkDeviceSize & offset );
+
+	std::vector< pool_t > m_pools;
+};
\ No newline at end of file
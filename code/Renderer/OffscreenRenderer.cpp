@@ -4,8 +4,12 @@
 #include "OffscreenRenderer.h"
 #include "model.h"
 #include "Samplers.h"
+#include "RingBuffer.h"
+#include "SecondaryCommandBuffers.h"
 
 #include "../application.h"
+#include "../JobSystem.h"
+#include <algorithm>
 #include <assert.h>
 #include <stdio.h>
 #include <vector>
@@ -25,14 +29,98 @@ Pipeline	g_shadowPipeline;
 Shader		g_shadowShader;
 Descriptors	g_shadowDescriptors;
 
+// Depth of the shadow casters that never move, copied into the shadow map every frame.
+// Its render pass only differs by its load op, so it uses the shadow pipelines.
+FrameBuffer	g_staticShadowFrameBuffer;
+bool		g_isStaticShadowDirty = true;
+
+// Instanced variants, sharing the descriptors and fragment shaders above
+Pipeline	g_checkerboardShadowInstancedPipeline;
+Shader		g_checkerboardShadowInstancedShader;
+Pipeline	g_shadowInstancedPipeline;
+Shader		g_shadowInstancedShader;
+bool		g_isInstancingEnabled = false;
+
+// The draws are recorded by worker threads, the primary only executes them
+SecondaryCommandBuffers	g_secondaryCommandBuffers;
+
+// The model matrices are bound with dynamic offsets, so a descriptor set is
+// only written when the model uniforms move to another buffer
+static const int MODEL_UNIFORM_SLOT = 1;
+
+/*
+====================================================
+CreatePipelines
+
+Every pipeline is compiled by its own job, the pipeline
+cache takes care of the concurrent accesses
+====================================================
+*/
+struct PipelineCreation_t {
+	Pipeline *				pipeline;
+	Pipeline::CreateParms_t	parms;
+};
+
+static bool CreatePipelines( DeviceContext * device, JobSystem & jobSystem, const std::vector< PipelineCreation_t > & creations ) {
+	std::vector< unsigned char > results( creations.size(), 0 );
+
+	JobSystem::JobCounter counter( 0 );
+	for ( int i = 0; i < (int)creations.size(); i++ ) {
+		jobSystem.Submit( [device, &creations, &results, i] {
+				results[ i ] = creations[ i ].pipeline->Create( device, creations[ i ].parms );
+			}, &counter );
+	}
+	jobSystem.Wait( counter );
+
+	for ( int i = 0; i < (int)creations.size(); i++ ) {
+		if ( !results[ i ] ) {
+			printf( "ERROR: Failed to build pipeline\n" );
+			assert( 0 );
+			return false;
+		}
+	}
+	return true;
+}
+
 /*
 ====================================================
 InitOffscreen
 ====================================================
 */
-bool InitOffscreen( DeviceContext * device, int width, int height ) {
+bool InitOffscreen( DeviceContext * device, JobSystem & jobSystem, int width, int height ) {
 	bool result;
 
+	// The pipelines are only described here, then created in parallel once all the shaders are loaded
+	enum { SHADOW_PIPELINE, SKY_PIPELINE, CHECKERBOARD_SHADOW_PIPELINE };
+	std::vector< PipelineCreation_t > pipelineCreations;
+
+	//
+	//	Load all the shaders at once, the instanced ones may not be compiled
+	//
+	enum { SHADOW_SHADER, SKY_SHADER, CHECKERBOARD_SHADOW_SHADER, SHADOW_INSTANCED_SHADER, CHECKERBOARD_SHADOW_INSTANCED_SHADER, NUM_SHADERS };
+	Shader::LoadParms_t shaderLoads[ NUM_SHADERS ] = {
+		{ &g_shadowShader, "shadow2", NULL, false },
+		{ &g_skyShader, "sky", NULL, false },
+		{ &g_checkerboardShadowShader, "checkerboardShadowed2", NULL, false },
+		{ &g_shadowInstancedShader, "shadow2Instanced", "shadow2", false },
+		{ &g_checkerboardShadowInstancedShader, "checkerboardShadowed2Instanced", "checkerboardShadowed2", false },
+	};
+	Shader::LoadShaders( device, jobSystem, shaderLoads, NUM_SHADERS );
+	for ( int i = 0; i < SHADOW_INSTANCED_SHADER; i++ ) {
+		if ( !shaderLoads[ i ].isLoaded ) {
+			printf( "ERROR: Failed to load shader %s\n", shaderLoads[ i ].name );
+			assert( 0 );
+			return false;
+		}
+	}
+
+	result = g_secondaryCommandBuffers.Create( device );
+	if ( !result ) {
+		printf( "ERROR: Failed to create secondary command buffers\n" );
+		assert( 0 );
+		return false;
+	}
+
 	//
 	//	Build the frame buffer to render into
 	//
@@ -42,6 +130,7 @@ bool InitOffscreen( DeviceContext * device, int width, int height ) {
 		frameBufferParms.height = height;
 		frameBufferParms.hasColor = true;
 		frameBufferParms.hasDepth = true;
+		frameBufferParms.loadDepth = false;
 		result = g_offscreenFrameBuffer.Create( device, frameBufferParms );
 		if ( !result ) {
 			printf( "ERROR: Failed to create off screen buffer\n" );
@@ -59,6 +148,7 @@ bool InitOffscreen( DeviceContext * device, int width, int height ) {
 		frameBufferParms.height = 4096;
 		frameBufferParms.hasColor = false;
 		frameBufferParms.hasDepth = true;
+		frameBufferParms.loadDepth = true;	// starts from a copy of the static shadows
 		result = g_shadowFrameBuffer.Create( device, frameBufferParms );
 		if ( !result ) {
 			printf( "ERROR: Failed to create off screen buffer\n" );
@@ -66,16 +156,19 @@ bool InitOffscreen( DeviceContext * device, int width, int height ) {
 			return false;
 		}
 
-		result = g_shadowShader.Load( device, "shadow2" );
+		frameBufferParms.loadDepth = false;
+		result = g_staticShadowFrameBuffer.Create( device, frameBufferParms );
 		if ( !result ) {
-			printf( "ERROR: Failed to load shader\n" );
+			printf( "ERROR: Failed to create off screen buffer\n" );
 			assert( 0 );
 			return false;
 		}
+		g_isStaticShadowDirty = true;
 
 		Descriptors::CreateParms_t descriptorParms;
 		memset( &descriptorParms, 0, sizeof( descriptorParms ) );
 		descriptorParms.numUniformsVertex = 2;
+		descriptorParms.dynamicUniformsMask = 1 << MODEL_UNIFORM_SLOT;
 		result = g_shadowDescriptors.Create( device, descriptorParms );
 		if ( !result ) {
 			printf( "ERROR: Failed to build descriptors\n" );
@@ -92,25 +185,13 @@ bool InitOffscreen( DeviceContext * device, int width, int height ) {
 		pipelineParms.cullMode = Pipeline::CULL_MODE_FRONT;
 		pipelineParms.depthTest = true;
 		pipelineParms.depthWrite = true;
-		result = g_shadowPipeline.Create( device, pipelineParms );
-		if ( !result ) {
-			printf( "ERROR: Failed to build pipeline\n" );
-			assert( 0 );
-			return false;
-		}
+		pipelineCreations.push_back( { &g_shadowPipeline, pipelineParms } );
 	}
 
 	//
 	//	Sky
 	//
 	{
-		result = g_skyShader.Load( device, "sky" );
-		if ( !result ) {
-			printf( "ERROR: Failed to load shader\n" );
-			assert( 0 );
-			return false;
-		}
-
 		Descriptors::CreateParms_t descriptorParms;
 		memset( &descriptorParms, 0, sizeof( descriptorParms ) );
 		descriptorParms.numUniformsVertex = 1;
@@ -130,12 +211,7 @@ bool InitOffscreen( DeviceContext * device, int width, int height ) {
 		pipelineParms.cullMode = Pipeline::CULL_MODE_NONE;
 		pipelineParms.depthTest = false;
 		pipelineParms.depthWrite = false;
-		result = g_skyPipeline.Create( device, pipelineParms );
-		if ( !result ) {
-			printf( "ERROR: Failed to build pipeline\n" );
-			assert( 0 );
-			return false;
-		}
+		pipelineCreations.push_back( { &g_skyPipeline, pipelineParms } );
 
 		ShapeSphere sphereShape( 1.0f );
 		g_skyModel.BuildFromShape( &sphereShape );
@@ -146,17 +222,11 @@ bool InitOffscreen( DeviceContext * device, int width, int height ) {
 	//	CheckerBoard Shadow
 	//
 	{
-		result = g_checkerboardShadowShader.Load( device, "checkerboardShadowed2" );
-		if ( !result ) {
-			printf( "ERROR: Failed to load shader\n" );
-			assert( 0 );
-			return false;
-		}
-
 		Descriptors::CreateParms_t descriptorParms;
 		memset( &descriptorParms, 0, sizeof( descriptorParms ) );
 		descriptorParms.numUniformsVertex = 3;
 		descriptorParms.numUniformsFragment = 1;
+		descriptorParms.dynamicUniformsMask = 1 << MODEL_UNIFORM_SLOT;
 		descriptorParms.numImageSamplers = 1;
 		result = g_checkerboardShadowDescriptors.Create( device, descriptorParms );
 		if ( !result ) {
@@ -174,23 +244,61 @@ bool InitOffscreen( DeviceContext * device, int width, int height ) {
 		pipelineParms.cullMode = Pipeline::CULL_MODE_BACK;
 		pipelineParms.depthTest = true;
 		pipelineParms.depthWrite = true;
-		result = g_checkerboardShadowPipeline.Create( device, pipelineParms );
-		if ( !result ) {
-			printf( "ERROR: Failed to build pipeline\n" );
-			assert( 0 );
-			return false;
-		}
+		pipelineCreations.push_back( { &g_checkerboardShadowPipeline, pipelineParms } );
+	}
+
+	//
+	//	Instancing, the models are drawn one at a time when the shaders aren't compiled
+	//
+	g_isInstancingEnabled = shaderLoads[ SHADOW_INSTANCED_SHADER ].isLoaded && shaderLoads[ CHECKERBOARD_SHADOW_INSTANCED_SHADER ].isLoaded;
+	if ( !g_isInstancingEnabled ) {
+		printf( "WARNING: Instanced shaders not found, drawing the models one at a time\n" );
+		g_shadowInstancedShader.Cleanup( device );
+		g_checkerboardShadowInstancedShader.Cleanup( device );
+	} else {
+		PipelineCreation_t creation = pipelineCreations[ SHADOW_PIPELINE ];
+		creation.pipeline = &g_shadowInstancedPipeline;
+		creation.parms.shader = &g_shadowInstancedShader;
+		creation.parms.isInstanced = true;
+		pipelineCreations.push_back( creation );
+
+		creation = pipelineCreations[ CHECKERBOARD_SHADOW_PIPELINE ];
+		creation.pipeline = &g_checkerboardShadowInstancedPipeline;
+		creation.parms.shader = &g_checkerboardShadowInstancedShader;
+		creation.parms.isInstanced = true;
+		pipelineCreations.push_back( creation );
+	}
+
+	//
+	//	Compile all the pipelines at once
+	//
+	result = CreatePipelines( device, jobSystem, pipelineCreations );
+	if ( !result ) {
+		printf( "ERROR: Failed to build pipelines\n" );
+		assert( 0 );
+		return false;
 	}
 
 	return true;
 }
 
+/*
+====================================================
+IsInstancingEnabled
+====================================================
+*/
+bool IsInstancingEnabled() {
+	return g_isInstancingEnabled;
+}
+
 /*
 ====================================================
 CleanupOffscreen
 ====================================================
 */
 bool CleanupOffscreen( DeviceContext * device ) {
+	g_secondaryCommandBuffers.Cleanup( device );
+
 	g_skyPipeline.Cleanup( device );
 	g_skyDescriptors.Cleanup( device );
 	g_skyShader.Cleanup( device );
@@ -205,93 +313,362 @@ bool CleanupOffscreen( DeviceContext * device ) {
 	g_shadowShader.Cleanup( device );
 	g_shadowDescriptors.Cleanup( device );
 	g_shadowFrameBuffer.Cleanup( device );
+	g_staticShadowFrameBuffer.Cleanup( device );
+
+	if ( g_isInstancingEnabled ) {
+		g_shadowInstancedPipeline.Cleanup( device );
+		g_shadowInstancedShader.Cleanup( device );
+		g_checkerboardShadowInstancedPipeline.Cleanup( device );
+		g_checkerboardShadowInstancedShader.Cleanup( device );
+		g_isInstancingEnabled = false;
+	}
 	return true;
 }
 
+/*
+====================================================
+InvalidateStaticShadow
+====================================================
+*/
+void InvalidateStaticShadow() {
+	g_isStaticShadowDirty = true;
+}
+
+/*
+====================================================
+IsStaticShadowDirty
+====================================================
+*/
+bool IsStaticShadowDirty() {
+	return g_isStaticShadowDirty;
+}
+
+/*
+====================================================
+PassRecording_t
+
+A pass split in chunks of draws, each chunk recorded into
+its own secondary command buffer by a job. The descriptor
+sets are all written beforehand on the calling thread.
+====================================================
+*/
+struct DescriptorRun_t {
+	int			firstDraw;	// the descriptor is bound from this draw until the next run
+	Descriptor	descriptor;
+};
+
+struct PassRecording_t {
+	FrameBuffer *		frameBuffer;
+	Pipeline *			pipeline;
+	const DrawList_t *	drawList;
+	int					numDraws;
+	std::vector< DescriptorRun_t > descriptorRuns;	// a single run when instanced
+
+	int					firstSlot;		// the secondary command buffers of the chunks
+	int					numChunks;
+	int					drawsPerChunk;
+};
+
+PassRecording_t	g_passRecordings[ NUM_DRAW_PASSES ];
+Descriptor		g_skyDescriptor;
+
+// Below this many draws a chunk costs more to dispatch than to record.
+// Only the per body path gets split: instanced passes hold one draw per mesh and lod,
+// whatever the body count, and are each recorded as a single chunk.
+static const int MIN_DRAWS_PER_CHUNK = 128;
+static const int MAX_CHUNKS_PER_PASS = SecondaryCommandBuffers::MAX_SLOTS / NUM_DRAW_PASSES;
+
+/*
+====================================================
+PrepareShadowCasters
+====================================================
+*/
+static void PrepareShadowCasters( DeviceContext * device, PassRecording_t & pass, const RingAllocation_t & shadowCameraUniforms ) {
+	Buffer * shadowCamUniforms = shadowCameraUniforms.buffer;
+	const int shadowCamOffset = shadowCameraUniforms.offset;
+	const int shadowCamSize = shadowCameraUniforms.size;
+
+	const DrawList_t & drawList = *pass.drawList;
+	pass.descriptorRuns.clear();
+
+	if ( g_isInstancingEnabled ) {
+		// One draw per mesh, the model matrices come from the instance buffer
+		pass.pipeline = &g_shadowInstancedPipeline;
+		pass.numDraws = drawList.numBatches;
+
+		DescriptorRun_t run;
+		run.firstDraw = 0;
+		run.descriptor = g_shadowInstancedPipeline.GetFreeDescriptor();
+		run.descriptor.BindBuffer( shadowCamUniforms, shadowCamOffset, shadowCamSize, 0 );	// bind the camera matrices
+		run.descriptor.BindBuffer( shadowCamUniforms, 0, shadowCamSize, 1 );				// unused model slot of the shared layout
+		run.descriptor.UpdateDescriptor( device );
+		pass.descriptorRuns.push_back( run );
+		return;
+	}
+
+	pass.pipeline = &g_shadowPipeline;
+	pass.numDraws = drawList.numModels;
+
+	Buffer * descriptorModelUniforms = NULL;
+	for ( int i = 0; i < drawList.numModels; i++ ) {
+		const RenderModel & renderModel = drawList.renderModels[ i ];
+		if ( renderModel.uniformBuffer == descriptorModelUniforms ) {
+			continue;
+		}
+
+		// Descriptor is how we bind our buffers and images
+		DescriptorRun_t run;
+		run.firstDraw = i;
+		run.descriptor = g_shadowPipeline.GetFreeDescriptor();
+		run.descriptor.BindBuffer( shadowCamUniforms, shadowCamOffset, shadowCamSize, 0 );					// bind the camera matrices
+		run.descriptor.BindBuffer( renderModel.uniformBuffer, 0, renderModel.uboByteSize, MODEL_UNIFORM_SLOT );	// bind the model matrices
+		run.descriptor.UpdateDescriptor( device );
+		pass.descriptorRuns.push_back( run );
+		descriptorModelUniforms = renderModel.uniformBuffer;
+	}
+}
+
+/*
+====================================================
+PrepareWorld
+====================================================
+*/
+static void PrepareWorld( DeviceContext * device, PassRecording_t & pass, const RingAllocation_t & cameraUniforms, const RingAllocation_t & shadowCameraUniforms ) {
+	Buffer * camUniforms = cameraUniforms.buffer;
+	const int camOffset = cameraUniforms.offset;
+	const int camSize = cameraUniforms.size;
+
+	Buffer * shadowCamUniforms = shadowCameraUniforms.buffer;
+	const int shadowCamOffset = shadowCameraUniforms.offset;
+	const int shadowCamSize = shadowCameraUniforms.size;
+
+	const DrawList_t & drawList = *pass.drawList;
+	pass.descriptorRuns.clear();
+
+	// The sky is drawn first, by the first chunk
+	g_skyDescriptor = g_skyPipeline.GetFreeDescriptor();
+	g_skyDescriptor.BindBuffer( camUniforms, camOffset, camSize, 0 );
+	g_skyDescriptor.UpdateDescriptor( device );
+
+	if ( g_isInstancingEnabled ) {
+		// One draw per mesh, the model matrices come from the instance buffer
+		pass.pipeline = &g_checkerboardShadowInstancedPipeline;
+		pass.numDraws = drawList.numBatches;
+
+		DescriptorRun_t run;
+		run.firstDraw = 0;
+		run.descriptor = g_checkerboardShadowInstancedPipeline.GetFreeDescriptor();
+		run.descriptor.BindBuffer( camUniforms, camOffset, camSize, 0 );					// bind the camera matrices
+		run.descriptor.BindBuffer( camUniforms, 0, camSize, 1 );							// unused model slot of the shared layout
+		run.descriptor.BindBuffer( shadowCamUniforms, shadowCamOffset, shadowCamSize, 2 );	// bind the shadow camera matrices
+		run.descriptor.BindImage( VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, g_shadowFrameBuffer.m_imageDepth.m_vkImageView, Samplers::m_samplerStandard, 0 );
+		run.descriptor.UpdateDescriptor( device );
+		pass.descriptorRuns.push_back( run );
+		return;
+	}
+
+	pass.pipeline = &g_checkerboardShadowPipeline;
+	pass.numDraws = drawList.numModels;
+
+	Buffer * descriptorModelUniforms = NULL;
+	for ( int i = 0; i < drawList.numModels; i++ ) {
+		const RenderModel & renderModel = drawList.renderModels[ i ];
+		if ( renderModel.uniformBuffer == descriptorModelUniforms ) {
+			continue;
+		}
+
+		// Descriptor is how we bind our buffers and images
+		DescriptorRun_t run;
+		run.firstDraw = i;
+		run.descriptor = g_checkerboardShadowPipeline.GetFreeDescriptor();
+		run.descriptor.BindBuffer( camUniforms, camOffset, camSize, 0 );										// bind the camera matrices
+		run.descriptor.BindBuffer( renderModel.uniformBuffer, 0, renderModel.uboByteSize, MODEL_UNIFORM_SLOT );	// bind the model matrices
+		run.descriptor.BindBuffer( shadowCamUniforms, shadowCamOffset, shadowCamSize, 2 );						// bind the shadow camera matrices
+		run.descriptor.BindImage( VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, g_shadowFrameBuffer.m_imageDepth.m_vkImageView, Samplers::m_samplerStandard, 0 );
+		run.descriptor.UpdateDescriptor( device );
+		pass.descriptorRuns.push_back( run );
+		descriptorModelUniforms = renderModel.uniformBuffer;
+	}
+}
+
+/*
+====================================================
+RecordChunk
+
+Runs on a worker thread, only reads shared state
+====================================================
+*/
+static void RecordChunk( const PassRecording_t & pass, const int chunk, const bool drawSky, const RingAllocation_t & instances ) {
+	const int slot = pass.firstSlot + chunk;
+	VkCommandBuffer cmdBuffer = g_secondaryCommandBuffers.Begin( slot, pass.frameBuffer );
+
+	if ( drawSky ) {
+		// Binding the pipeline is effectively the "use shader" we had back in our opengl apps
+		g_skyPipeline.BindPipeline( cmdBuffer );
+		g_skyDescriptor.BindDescriptor( cmdBuffer, &g_skyPipeline, nullptr, 0 );
+		g_skyModel.DrawIndexed( cmdBuffer );
+	}
+
+	const int firstDraw = chunk * pass.drawsPerChunk;
+	const int endDraw = std::min( firstDraw + pass.drawsPerChunk, pass.numDraws );
+	if ( firstDraw < endDraw ) {
+		const DrawList_t & drawList = *pass.drawList;
+		pass.pipeline->BindPipeline( cmdBuffer );
+
+		if ( g_isInstancingEnabled ) {
+			const uint32_t modelOffset = 0;
+			pass.descriptorRuns[ 0 ].descriptor.BindDescriptor( cmdBuffer, pass.pipeline, &modelOffset, 1 );
+			for ( int i = firstDraw; i < endDraw; i++ ) {
+				const RenderBatch & renderBatch = drawList.renderBatches[ i ];
+				renderBatch.model->DrawIndexedInstanced( cmdBuffer, instances.buffer, instances.offset, renderBatch.firstInstance, renderBatch.numInstances );
+			}
+		} else {
+			// The last run starting at or before the chunk
+			int run = 0;
+			while ( run + 1 < (int)pass.descriptorRuns.size() && pass.descriptorRuns[ run + 1 ].firstDraw <= firstDraw ) {
+				run++;
+			}
+
+			for ( int i = firstDraw; i < endDraw; i++ ) {
+				if ( run + 1 < (int)pass.descriptorRuns.size() && pass.descriptorRuns[ run + 1 ].firstDraw == i ) {
+					run++;
+				}
+
+				const RenderModel & renderModel = drawList.renderModels[ i ];
+				const uint32_t modelOffset = renderModel.uboByteOffset;
+				pass.descriptorRuns[ run ].descriptor.BindDescriptor( cmdBuffer, pass.pipeline, &modelOffset, 1 );
+				renderModel.model->DrawIndexed( cmdBuffer );
+			}
+		}
+	}
+
+	g_secondaryCommandBuffers.End( slot );
+}
+
 /*
 ====================================================
 DrawOffscreen
 ====================================================
 */
-void DrawOffscreen( DeviceContext * device, int cmdBufferIndex, Buffer * uniforms, const RenderModel * renderModels, const int numModels ) {
+void DrawOffscreen( DeviceContext * device, JobSystem & jobSystem, int cmdBufferIndex, const RingAllocation_t & cameraUniforms, const RingAllocation_t & shadowCameraUniforms, const RingAllocation_t & instances, const DrawList_t * drawLists ) {
 	VkCommandBuffer cmdBuffer = device->m_vkCommandBuffers[ cmdBufferIndex ];
 
-	const int camOffset = 0;
-	const int camSize = sizeof( float ) * 16 * 4;
-
-	const int shadowCamOffset = device->GetAligendUniformByteOffset( camOffset + camSize );
-	const int shadowCamSize = camSize;
+	g_shadowDescriptors.BeginFrame( device );
+	g_skyDescriptors.BeginFrame( device );
+	g_checkerboardShadowDescriptors.BeginFrame( device );
+	g_secondaryCommandBuffers.BeginFrame( device );
 
 	//
-	//	Update the Shadows
+	//	Write the descriptors, then split the passes in chunks.
+	//	The static shadow casters are only drawn when the cache has been invalidated.
 	//
-	{
-		g_shadowFrameBuffer.m_imageDepth.TransitionLayout( cmdBuffer, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL );
+	const bool isStaticShadowDirty = g_isStaticShadowDirty;
+	int numSlots = 0;
+	for ( int i = 0; i < NUM_DRAW_PASSES; i++ ) {
+		PassRecording_t & pass = g_passRecordings[ i ];
+		pass.drawList = &drawLists[ i ];
+		pass.numDraws = 0;
+		pass.numChunks = 0;
+		pass.drawsPerChunk = 0;
+
+		switch ( i ) {
+			case DRAW_PASS_STATIC_SHADOW: {
+				pass.frameBuffer = &g_staticShadowFrameBuffer;
+				if ( isStaticShadowDirty ) {
+					PrepareShadowCasters( device, pass, shadowCameraUniforms );
+				}
+			} break;
+			case DRAW_PASS_SHADOW: {
+				pass.frameBuffer = &g_shadowFrameBuffer;
+				PrepareShadowCasters( device, pass, shadowCameraUniforms );
+			} break;
+			case DRAW_PASS_MAIN: {
+				pass.frameBuffer = &g_offscreenFrameBuffer;
+				PrepareWorld( device, pass, cameraUniforms, shadowCameraUniforms );
+			} break;
+		}
 
-		g_shadowFrameBuffer.BeginRenderPass( device, cmdBufferIndex );
+		if ( DRAW_PASS_STATIC_SHADOW != i || isStaticShadowDirty ) {
+			// Even an empty pass gets a chunk, the render pass still clears its target
+			const int numChunks = ( pass.numDraws + MIN_DRAWS_PER_CHUNK - 1 ) / MIN_DRAWS_PER_CHUNK;
+			pass.numChunks = std::max( 1, std::min( numChunks, MAX_CHUNKS_PER_PASS ) );
+			pass.drawsPerChunk = ( pass.numDraws + pass.numChunks - 1 ) / pass.numChunks;
+		}
+		pass.firstSlot = numSlots;
+		numSlots += pass.numChunks;
+	}
 
-		// Binding the pipeline is effectively the "use shader" we had back in our opengl apps
-		g_shadowPipeline.BindPipeline( cmdBuffer );
-		for ( int i = 0; i < numModels; i++ ) {
-			const RenderModel & renderModel = renderModels[ i ];
-
-			// Descriptor is how we bind our buffers and images
-			Descriptor descriptor = g_shadowPipeline.GetFreeDescriptor();
-			descriptor.BindBuffer( uniforms, shadowCamOffset, shadowCamSize, 0 );						// bind the camera matrices
-			descriptor.BindBuffer( uniforms, renderModel.uboByteOffset, renderModel.uboByteSize, 1 );	// bind the model matrices
-			descriptor.BindDescriptor( device, cmdBuffer, &g_shadowPipeline );
-			renderModel.model->DrawIndexed( cmdBuffer );
+	//
+	//	Record the chunks of all the passes at once
+	//
+	JobSystem::JobCounter counter( 0 );
+	for ( int i = 0; i < NUM_DRAW_PASSES; i++ ) {
+		const PassRecording_t * pass = &g_passRecordings[ i ];
+		for ( int chunk = 0; chunk < pass->numChunks; chunk++ ) {
+			const bool drawSky = ( DRAW_PASS_MAIN == i && 0 == chunk );
+			jobSystem.Submit( [pass, chunk, drawSky, &instances] {
+					RecordChunk( *pass, chunk, drawSky, instances );
+				}, &counter );
 		}
+	}
+	jobSystem.Wait( counter );
 
-		g_shadowFrameBuffer.EndRenderPass( device, cmdBufferIndex );
+	//
+	//	Render the static shadow casters
+	//
+	if ( isStaticShadowDirty ) {
+		const PassRecording_t & pass = g_passRecordings[ DRAW_PASS_STATIC_SHADOW ];
+		g_staticShadowFrameBuffer.m_imageDepth.TransitionLayout( cmdBuffer, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL );
 
-		g_shadowFrameBuffer.m_imageDepth.TransitionLayout( cmdBuffer, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL );
+		g_staticShadowFrameBuffer.BeginRenderPass( device, cmdBufferIndex, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+		g_secondaryCommandBuffers.Execute( cmdBuffer, pass.firstSlot, pass.numChunks );
+		g_staticShadowFrameBuffer.EndRenderPass( device, cmdBufferIndex );
+
+		g_isStaticShadowDirty = false;
 	}
 
 	//
-	//	Draw the World
+	//	Update the Shadows, the moving casters are drawn over a copy of the static ones
 	//
 	{
-		g_offscreenFrameBuffer.m_imageColor.TransitionLayout( cmdBuffer, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL );
+		const PassRecording_t & pass = g_passRecordings[ DRAW_PASS_SHADOW ];
+		Image & staticDepth = g_staticShadowFrameBuffer.m_imageDepth;
+		Image & shadowDepth = g_shadowFrameBuffer.m_imageDepth;
+		staticDepth.TransitionLayout( cmdBuffer, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL );
+
+		// The copy overwrites all of it, the last frame's shadows can be discarded
+		shadowDepth.m_vkImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		shadowDepth.TransitionLayout( cmdBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL );
+
+		VkImageCopy region = {};
+		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		region.srcSubresource.layerCount = 1;
+		region.dstSubresource = region.srcSubresource;
+		region.extent.width = shadowDepth.m_parms.width;
+		region.extent.height = shadowDepth.m_parms.height;
+		region.extent.depth = 1;
+		vkCmdCopyImage( cmdBuffer, staticDepth.m_vkImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, shadowDepth.m_vkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region );
+
+		shadowDepth.TransitionLayout( cmdBuffer, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL );
+
+		g_shadowFrameBuffer.BeginRenderPass( device, cmdBufferIndex, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+		g_secondaryCommandBuffers.Execute( cmdBuffer, pass.firstSlot, pass.numChunks );
+		g_shadowFrameBuffer.EndRenderPass( device, cmdBufferIndex );
 
-		g_offscreenFrameBuffer.BeginRenderPass( device, cmdBufferIndex );
+		shadowDepth.TransitionLayout( cmdBuffer, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL );
+	}
 
-		//
-		//	Draw the sky
-		//
-		{
-			// Binding the pipeline is effectively the "use shader" we had back in our opengl apps
-			g_skyPipeline.BindPipeline( cmdBuffer );
-	
-			// Descriptor is how we bind our buffers and images
-			Descriptor descriptor = g_skyPipeline.GetFreeDescriptor();
-			descriptor.BindBuffer( uniforms, camOffset, camSize, 0 );
-			descriptor.BindDescriptor( device, cmdBuffer, &g_skyPipeline );
-			g_skyModel.DrawIndexed( cmdBuffer );
-		}
-	
-		//
-		//	Draw the models
-		//
-		{
-			// Binding the pipeline is effectively the "use shader" we had back in our opengl apps
-			g_checkerboardShadowPipeline.BindPipeline( cmdBuffer );
-			for ( int i = 0; i < numModels; i++ ) {
-				const RenderModel & renderModel = renderModels[ i ];
-
-				// Descriptor is how we bind our buffers and images
-				Descriptor descriptor = g_checkerboardShadowPipeline.GetFreeDescriptor();
-				descriptor.BindBuffer( uniforms, camOffset, camSize, 0 );									// bind the camera matrices
-				descriptor.BindBuffer( uniforms, renderModel.uboByteOffset, renderModel.uboByteSize, 1 );	// bind the model matrices
-				descriptor.BindBuffer( uniforms, shadowCamOffset, shadowCamSize, 2 );						// bind the shadow camera matrices
-				descriptor.BindImage( VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, g_shadowFrameBuffer.m_imageDepth.m_vkImageView, Samplers::m_samplerStandard, 0 );
-				descriptor.BindDescriptor( device, cmdBuffer, &g_checkerboardShadowPipeline );
-				renderModel.model->DrawIndexed( cmdBuffer );
-			}
-		}
+	//
+	//	Draw the World, sky included
+	//
+	{
+		const PassRecording_t & pass = g_passRecordings[ DRAW_PASS_MAIN ];
+		g_offscreenFrameBuffer.m_imageColor.TransitionLayout( cmdBuffer, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL );
 
+		g_offscreenFrameBuffer.BeginRenderPass( device, cmdBufferIndex, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+		g_secondaryCommandBuffers.Execute( cmdBuffer, pass.firstSlot, pass.numChunks );
 		g_offscreenFrameBuffer.EndRenderPass( device, cmdBufferIndex );
 
 		g_offscreenFrameBuffer.m_imageColor.TransitionLayout( cmdBuffer, VK_IMAGE_LAYOUT_GENERAL );		
 	}
-}
+}
\ No newline at end of file
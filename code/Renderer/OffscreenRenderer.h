@@ -4,10 +4,43 @@
 #pragma once
 
 class DeviceContext;
+class JobSystem;
 class Buffer;
+struct RingAllocation_t;
 struct RenderModel;
+struct RenderBatch;
 
-bool InitOffscreen( DeviceContext * device, int width, int height );
+enum drawPass_t {
+	DRAW_PASS_STATIC_SHADOW,	// into the static shadow cache, empty unless it's dirty
+	DRAW_PASS_SHADOW,
+	DRAW_PASS_MAIN,
+	NUM_DRAW_PASSES
+};
+
+/*
+====================================================
+DrawList_t
+
+What a pass draws once culled, per body models when
+instancing is off, per mesh batches when it's on
+====================================================
+*/
+struct DrawList_t {
+	const RenderModel *	renderModels;
+	int					numModels;
+	const RenderBatch *	renderBatches;
+	int					numBatches;
+};
+
+// The pipelines are compiled on the job system
+bool InitOffscreen( DeviceContext * device, JobSystem & jobSystem, int width, int height );
 bool CleanupOffscreen( DeviceContext * device );
+bool IsInstancingEnabled();
+
+// The static shadow casters are rendered once into a cache, then only
+// when invalidated. The next DrawOffscreen rebuilds it and clears the flag.
+void InvalidateStaticShadow();
+bool IsStaticShadowDirty();
 
-void DrawOffscreen( DeviceContext * device, int cmdBufferIndex, Buffer * uniforms, const RenderModel * renderModels, const int numModels );
\ No newline at end of file
+// drawLists holds one list per drawPass_t, the passes are recorded in chunks on the job system
+void DrawOffscreen( DeviceContext * device, JobSystem & jobSystem, int cmdBufferIndex, const RingAllocation_t & cameraUniforms, const RingAllocation_t & shadowCameraUniforms, const RingAllocation_t & instances, const DrawList_t * drawLists );
\ No newline at end of file
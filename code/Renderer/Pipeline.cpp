@@ -7,6 +7,7 @@
 #include "FrameBuffer.h"
 #include "Descriptor.h"
 #include "model.h"
+#include "PipelineCache.h"
 #include <assert.h>
 
 /*
@@ -67,12 +68,22 @@ bool Pipeline::Create( DeviceContext * device, const CreateParms_t & parms ) {
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-	VkVertexInputBindingDescription bindingDescription = vert_t::GetBindingDescription();
-	std::array< VkVertexInputAttributeDescription, 5 > attributeDescriptions = vert_t::GetAttributeDescriptions();
+	std::vector< VkVertexInputBindingDescription > bindingDescriptions;
+	std::vector< VkVertexInputAttributeDescription > attributeDescriptions;
+	{
+		std::array< VkVertexInputAttributeDescription, 5 > vertAttributes = vert_t::GetAttributeDescriptions();
+		bindingDescriptions.push_back( vert_t::GetBindingDescription() );
+		attributeDescriptions.insert( attributeDescriptions.end(), vertAttributes.begin(), vertAttributes.end() );
+	}
+	if ( parms.isInstanced ) {
+		std::array< VkVertexInputAttributeDescription, 4 > instanceAttributes = instance_t::GetAttributeDescriptions();
+		bindingDescriptions.push_back( instance_t::GetBindingDescription() );
+		attributeDescriptions.insert( attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end() );
+	}
 
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.vertexBindingDescriptionCount = (uint32_t)bindingDescriptions.size();
 	vertexInputInfo.vertexAttributeDescriptionCount = (uint32_t)attributeDescriptions.size();
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
@@ -203,7 +214,8 @@ bool Pipeline::Create( DeviceContext * device, const CreateParms_t & parms ) {
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-	VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+	// The cache is internally synchronized, pipelines may be created from several threads
+	VkPipelineCache pipelineCache = ( NULL != device->m_pipelineCache ) ? device->m_pipelineCache->m_vkPipelineCache : VK_NULL_HANDLE;
 
 	result = vkCreateGraphicsPipelines( device->m_vkDevice, pipelineCache, 1, &pipelineInfo, nullptr, &m_vkPipeline );
 	if ( VK_SUCCESS != result ) {
@@ -261,7 +273,9 @@ bool Pipeline::CreateCompute( DeviceContext * device, const CreateParms_t & parm
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;	
 	
 
-	result = vkCreateComputePipelines( device->m_vkDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_vkPipeline );
+	VkPipelineCache pipelineCache = ( NULL != device->m_pipelineCache ) ? device->m_pipelineCache->m_vkPipelineCache : VK_NULL_HANDLE;
+
+	result = vkCreateComputePipelines( device->m_vkDevice, pipelineCache, 1, &pipelineInfo, nullptr, &m_vkPipeline );
 	if ( VK_SUCCESS != result ) {
 		printf( "ERROR: Failed to create pipeline\n" );
 		assert( 0 );
@@ -46,6 +46,8 @@ public:
 		bool depthTest;
 		bool depthWrite;
 
+		bool isInstanced;	// reads an instance_t per instance from the vertex buffer bound at instance_t::BINDING
+
 		int pushConstantSize;
 		VkShaderStageFlagBits pushConstantShaderStages;
 	};
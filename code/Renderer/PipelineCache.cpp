@@ -0,0 +1,129 @@
+//
+//  PipelineCache.cpp
+//
+#include "PipelineCache.h"
+#include "DeviceContext.h"
+#include "../Fileio.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/*
+================================================================================================
+
+PipelineCache
+
+================================================================================================
+*/
+
+/*
+====================================================
+PipelineCache::Create
+====================================================
+*/
+bool PipelineCache::Create( DeviceContext * device, const char * fileName ) {
+	strncpy( m_fileName, fileName, MAX_FILE_NAME - 1 );
+	m_fileName[ MAX_FILE_NAME - 1 ] = '\0';
+
+	// A cache from another driver or device is dropped, the pipelines are compiled again
+	unsigned char * data = NULL;
+	unsigned int size = 0;
+	if ( GetFileData( m_fileName, &data, size ) ) {
+		if ( !IsCompatible( device, data, size ) ) {
+			printf( "WARNING: Pipeline cache %s is from another device or driver, ignoring it\n", m_fileName );
+			size = 0;
+		}
+	}
+
+	VkPipelineCacheCreateInfo cacheInfo = {};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.initialDataSize = size;
+	cacheInfo.pInitialData = ( size > 0 ) ? data : NULL;
+
+	VkResult result = vkCreatePipelineCache( device->m_vkDevice, &cacheInfo, nullptr, &m_vkPipelineCache );
+	if ( NULL != data ) {
+		free( data );
+	}
+	if ( VK_SUCCESS != result ) {
+		printf( "ERROR: Failed to create pipeline cache\n" );
+		assert( 0 );
+		return false;
+	}
+
+	return true;
+}
+
+/*
+====================================================
+PipelineCache::Cleanup
+====================================================
+*/
+void PipelineCache::Cleanup( DeviceContext * device ) {
+	if ( VK_NULL_HANDLE == m_vkPipelineCache ) {
+		return;
+	}
+
+	Save( device );
+
+	vkDestroyPipelineCache( device->m_vkDevice, m_vkPipelineCache, nullptr );
+	m_vkPipelineCache = VK_NULL_HANDLE;
+}
+
+/*
+====================================================
+PipelineCache::Save
+====================================================
+*/
+bool PipelineCache::Save( DeviceContext * device ) {
+	size_t size = 0;
+	VkResult result = vkGetPipelineCacheData( device->m_vkDevice, m_vkPipelineCache, &size, nullptr );
+	if ( VK_SUCCESS != result || 0 == size ) {
+		return false;
+	}
+
+	std::vector< unsigned char > data( size );
+	result = vkGetPipelineCacheData( device->m_vkDevice, m_vkPipelineCache, &size, data.data() );
+	if ( VK_SUCCESS != result ) {
+		printf( "ERROR: Failed to get pipeline cache data\n" );
+		return false;
+	}
+
+	return SaveFileData( m_fileName, data.data(), (unsigned int)size );
+}
+
+/*
+====================================================
+PipelineCache::IsCompatible
+
+Checks the header written by the driver, as laid out
+by VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+====================================================
+*/
+bool PipelineCache::IsCompatible( DeviceContext * device, const unsigned char * data, const unsigned int size ) const {
+	const unsigned int headerSize = 16 + VK_UUID_SIZE;
+	if ( size < headerSize ) {
+		return false;
+	}
+
+	uint32_t header[ 4 ];
+	memcpy( header, data, sizeof( header ) );
+	const uint32_t length = header[ 0 ];
+	const uint32_t version = header[ 1 ];
+	const uint32_t vendorID = header[ 2 ];
+	const uint32_t deviceID = header[ 3 ];
+	const unsigned char * uuid = data + sizeof( header );
+
+	const VkPhysicalDeviceProperties & properties = device->m_physicalDevices[ device->m_deviceIndex ].m_vkDeviceProperties;
+	if ( length < headerSize || length > size ) {
+		return false;
+	}
+	if ( VK_PIPELINE_CACHE_HEADER_VERSION_ONE != version ) {
+		return false;
+	}
+	if ( properties.vendorID != vendorID || properties.deviceID != deviceID ) {
+		return false;
+	}
+	return 0 == memcmp( properties.pipelineCacheUUID, uuid, VK_UUID_SIZE );
+}
\ No newline at end of file
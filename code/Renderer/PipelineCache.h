@@ -0,0 +1,39 @@
+//
+//  PipelineCache.h
+//
+#pragma once
+#include <vulkan/vulkan.h>
+
+class DeviceContext;
+
+/*
+================================================================================================
+
+PipelineCache
+
+Keeps the compiled pipelines from one run to the next. The cache is loaded
+from disk when it was saved by the same driver on the same device, checked
+against the vendor, device and pipeline cache UUID of its header, and saved
+back when the device is torn down. Pipelines can be created from several
+threads at once with it, the driver synchronizes the accesses.
+
+================================================================================================
+*/
+class PipelineCache {
+public:
+	PipelineCache() : m_vkPipelineCache( VK_NULL_HANDLE ) {}
+	~PipelineCache() {}
+
+	bool Create( DeviceContext * device, const char * fileName );
+	void Cleanup( DeviceContext * device );	// saves the cache before destroying it
+
+	bool Save( DeviceContext * device );
+
+	VkPipelineCache m_vkPipelineCache;
+
+private:
+	bool IsCompatible( DeviceContext * device, const unsigned char * data, const unsigned int size ) const;
+
+	static const int MAX_FILE_NAME = 256;
+	char m_fileName[ MAX_FILE_NAME ];
+};
\ No newline at end of file
@@ -0,0 +1,125 @@
+//
+//  RingBuffer.cpp
+//
+#include "RingBuffer.h"
+#include <assert.h>
+#include <stdio.h>
+
+/*
+================================================================================================
+
+RingBuffer
+
+================================================================================================
+*/
+
+/*
+====================================================
+RingBuffer::Create
+====================================================
+*/
+bool RingBuffer::Create( DeviceContext * device, VkBufferUsageFlagBits usageFlags ) {
+	m_usageFlags = usageFlags;
+
+	for ( int i = 0; i < DeviceContext::MAX_FRAMES_IN_FLIGHT; i++ ) {
+		chunk_t * chunk = CreateChunk( device, CHUNK_SIZE );
+		if ( NULL == chunk ) {
+			return false;
+		}
+		m_chunks[ i ].push_back( chunk );
+	}
+
+	BeginFrame( 0 );
+	return true;
+}
+
+/*
+====================================================
+RingBuffer::Cleanup
+====================================================
+*/
+void RingBuffer::Cleanup( DeviceContext * device ) {
+	for ( int i = 0; i < DeviceContext::MAX_FRAMES_IN_FLIGHT; i++ ) {
+		for ( int c = 0; c < (int)m_chunks[ i ].size(); c++ ) {
+			chunk_t * chunk = m_chunks[ i ][ c ];
+			chunk->buffer.UnmapBuffer( device );
+			chunk->buffer.Cleanup( device );
+			delete chunk;
+		}
+		m_chunks[ i ].clear();
+	}
+}
+
+/*
+====================================================
+RingBuffer::CreateChunk
+====================================================
+*/
+RingBuffer::chunk_t * RingBuffer::CreateChunk( DeviceContext * device, int size ) {
+	chunk_t * chunk = new chunk_t;
+	if ( !chunk->buffer.Allocate( device, NULL, size, m_usageFlags ) ) {
+		printf( "ERROR: Failed to allocate ring buffer chunk\n" );
+		assert( 0 );
+		delete chunk;
+		return NULL;
+	}
+
+	// Host coherent, so it stays mapped for its whole life
+	chunk->mapped = (unsigned char *)chunk->buffer.MapBuffer( device );
+	return chunk;
+}
+
+/*
+====================================================
+RingBuffer::BeginFrame
+====================================================
+*/
+void RingBuffer::BeginFrame( int frameIndex ) {
+	m_frameIndex = frameIndex % DeviceContext::MAX_FRAMES_IN_FLIGHT;
+	m_chunkIndex = 0;
+	m_chunkOffset = 0;
+}
+
+/*
+====================================================
+RingBuffer::Allocate
+====================================================
+*/
+RingAllocation_t RingBuffer::Allocate( DeviceContext * device, int size ) {
+	std::vector< chunk_t * > & chunks = m_chunks[ m_frameIndex ];
+
+	int offset = device->GetAligendUniformByteOffset( m_chunkOffset );
+	while ( offset + size > (int)chunks[ m_chunkIndex ]->buffer.m_vkBufferSize ) {
+		m_chunkIndex++;
+		offset = 0;
+
+		// Grow, big allocations get a chunk rounded up to the next power of two,
+		// so a slowly rising peak only adds a chunk each time it doubles
+		if ( m_chunkIndex == (int)chunks.size() ) {
+			int chunkSize = CHUNK_SIZE;
+			while ( chunkSize < size ) {
+				chunkSize *= 2;
+			}
+			chunk_t * newChunk = CreateChunk( device, chunkSize );
+			if ( NULL == newChunk ) {
+				printf( "ERROR: Failed to grow ring buffer for %i bytes\n", size );
+				assert( 0 );
+				m_chunkIndex--;
+
+				RingAllocation_t allocation = {};
+				return allocation;
+			}
+			chunks.push_back( newChunk );
+		}
+	}
+	m_chunkOffset = offset + size;
+
+	chunk_t * chunk = chunks[ m_chunkIndex ];
+
+	RingAllocation_t allocation;
+	allocation.buffer = &chunk->buffer;
+	allocation.offset = offset;
+	allocation.size = size;
+	allocation.data = chunk->mapped + offset;
+	return allocation;
+}
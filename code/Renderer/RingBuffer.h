@@ -0,0 +1,64 @@
+//
+//  RingBuffer.h
+//
+#pragma once
+#include "Buffer.h"
+#include <vector>
+
+/*
+====================================================
+RingAllocation_t
+====================================================
+*/
+struct RingAllocation_t {
+	Buffer *	buffer;
+	int			offset;	// byte offset into buffer, aligned for uniform offsets
+	int			size;
+	void *		data;	// persistently mapped, write only
+};
+
+/*
+================================================================================================
+
+RingBuffer
+
+Transient per frame GPU data. Each frame in flight owns a list of
+persistently mapped chunks, allocations are carved linearly out of
+them and all released at once when the frame index comes back
+around. A frame that runs out of room gets one more chunk, kept for
+the next frames, sized to a power of two of CHUNK_SIZE.
+
+================================================================================================
+*/
+class RingBuffer {
+public:
+	RingBuffer() : m_usageFlags( (VkBufferUsageFlagBits)0 ), m_frameIndex( 0 ), m_chunkIndex( 0 ), m_chunkOffset( 0 ) {}
+	~RingBuffer() {}
+
+	static const int CHUNK_SIZE = 256 * 1024;
+
+	bool Create( DeviceContext * device, VkBufferUsageFlagBits usageFlags );
+	void Cleanup( DeviceContext * device );
+
+	// Recycles the allocations made the last time this frame index was used,
+	// the gpu must be done with them
+	void BeginFrame( int frameIndex );
+	RingAllocation_t Allocate( DeviceContext * device, int size );
+
+private:
+	struct chunk_t {
+		Buffer			buffer;
+		unsigned char *	mapped;
+	};
+
+	chunk_t * CreateChunk( DeviceContext * device, int size );
+
+	VkBufferUsageFlagBits m_usageFlags;
+
+	// chunks are never moved, so the Buffer pointers handed out stay valid
+	std::vector< chunk_t * > m_chunks[ DeviceContext::MAX_FRAMES_IN_FLIGHT ];
+
+	int m_frameIndex;
+	int m_chunkIndex;	// chunk of the frame being filled
+	int m_chunkOffset;	// first free byte of that chunk
+};
@@ -0,0 +1,132 @@
+//
+//  SecondaryCommandBuffers.cpp
+//
+#include "SecondaryCommandBuffers.h"
+#include "FrameBuffer.h"
+#include <assert.h>
+#include <stdio.h>
+
+/*
+================================================================================================
+
+SecondaryCommandBuffers
+
+================================================================================================
+*/
+
+/*
+====================================================
+SecondaryCommandBuffers::Create
+====================================================
+*/
+bool SecondaryCommandBuffers::Create( DeviceContext * device ) {
+	VkResult result;
+
+	for ( int frame = 0; frame < DeviceContext::MAX_FRAMES_IN_FLIGHT; frame++ ) {
+		for ( int slot = 0; slot < MAX_SLOTS; slot++ ) {
+			// Transient, they are recorded again every frame
+			VkCommandPoolCreateInfo poolInfo = {};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.queueFamilyIndex = device->m_graphicsFamilyIdx;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+			result = vkCreateCommandPool( device->m_vkDevice, &poolInfo, nullptr, &m_vkCommandPools[ frame ][ slot ] );
+			if ( VK_SUCCESS != result ) {
+				printf( "ERROR: Failed to create command pool\n" );
+				assert( 0 );
+				return false;
+			}
+
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = m_vkCommandPools[ frame ][ slot ];
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			result = vkAllocateCommandBuffers( device->m_vkDevice, &allocInfo, &m_vkCommandBuffers[ frame ][ slot ] );
+			if ( VK_SUCCESS != result ) {
+				printf( "ERROR: Failed to allocate command buffers\n" );
+				assert( 0 );
+				return false;
+			}
+		}
+	}
+
+	m_frameIndex = 0;
+	return true;
+}
+
+/*
+====================================================
+SecondaryCommandBuffers::Cleanup
+====================================================
+*/
+void SecondaryCommandBuffers::Cleanup( DeviceContext * device ) {
+	for ( int frame = 0; frame < DeviceContext::MAX_FRAMES_IN_FLIGHT; frame++ ) {
+		for ( int slot = 0; slot < MAX_SLOTS; slot++ ) {
+			// Destroying the pool frees its command buffers
+			vkDestroyCommandPool( device->m_vkDevice, m_vkCommandPools[ frame ][ slot ], nullptr );
+		}
+	}
+}
+
+/*
+====================================================
+SecondaryCommandBuffers::BeginFrame
+====================================================
+*/
+void SecondaryCommandBuffers::BeginFrame( DeviceContext * device ) {
+	m_frameIndex = device->m_frameIndex;
+
+	for ( int slot = 0; slot < MAX_SLOTS; slot++ ) {
+		vkResetCommandPool( device->m_vkDevice, m_vkCommandPools[ m_frameIndex ][ slot ], 0 );
+	}
+}
+
+/*
+====================================================
+SecondaryCommandBuffers::Begin
+====================================================
+*/
+VkCommandBuffer SecondaryCommandBuffers::Begin( const int slot, FrameBuffer * frameBuffer ) {
+	assert( slot >= 0 && slot < MAX_SLOTS );
+	VkCommandBuffer cmdBuffer = m_vkCommandBuffers[ m_frameIndex ][ slot ];
+
+	VkCommandBufferInheritanceInfo inheritanceInfo = {};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = frameBuffer->m_vkRenderPass;
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = frameBuffer->m_vkFrameBuffer;
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+	vkBeginCommandBuffer( cmdBuffer, &beginInfo );
+
+	// Dynamic state isn't inherited from the primary
+	frameBuffer->SetDynamicState( cmdBuffer );
+	return cmdBuffer;
+}
+
+/*
+====================================================
+SecondaryCommandBuffers::End
+====================================================
+*/
+void SecondaryCommandBuffers::End( const int slot ) {
+	vkEndCommandBuffer( m_vkCommandBuffers[ m_frameIndex ][ slot ] );
+}
+
+/*
+====================================================
+SecondaryCommandBuffers::Execute
+====================================================
+*/
+void SecondaryCommandBuffers::Execute( VkCommandBuffer primary, const int firstSlot, const int numSlots ) {
+	if ( numSlots <= 0 ) {
+		return;
+	}
+	assert( firstSlot + numSlots <= MAX_SLOTS );
+	vkCmdExecuteCommands( primary, (uint32_t)numSlots, &m_vkCommandBuffers[ m_frameIndex ][ firstSlot ] );
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+//
+//  SecondaryCommandBuffers.h
+//
+#pragma once
+#include "DeviceContext.h"
+
+class FrameBuffer;
+
+/*
+================================================================================================
+
+SecondaryCommandBuffers
+
+Command buffers recorded by worker threads for a render pass begun on the
+primary. Every slot has its own command pool per frame in flight, and a slot
+is recorded by a single job at a time, so recording never takes a lock. The
+pools of a frame are reset all at once when the frame comes back around.
+
+================================================================================================
+*/
+class SecondaryCommandBuffers {
+public:
+	SecondaryCommandBuffers() : m_frameIndex( 0 ) {}
+	~SecondaryCommandBuffers() {}
+
+	static const int MAX_SLOTS = 32;
+
+	bool Create( DeviceContext * device );
+	void Cleanup( DeviceContext * device );
+
+	// The fence of the frame has been waited for, so its pools can be reset
+	void BeginFrame( DeviceContext * device );
+
+	// Safe to call from any thread, as long as no other thread is recording the same slot
+	VkCommandBuffer Begin( const int slot, FrameBuffer * frameBuffer );
+	void End( const int slot );
+
+	// The render pass must be begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+	void Execute( VkCommandBuffer primary, const int firstSlot, const int numSlots );
+
+private:
+	int				m_frameIndex;
+	VkCommandPool	m_vkCommandPools[ DeviceContext::MAX_FRAMES_IN_FLIGHT ][ MAX_SLOTS ];
+	VkCommandBuffer	m_vkCommandBuffers[ DeviceContext::MAX_FRAMES_IN_FLIGHT ][ MAX_SLOTS ];
+};
\ No newline at end of file
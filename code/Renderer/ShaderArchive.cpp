@@ -0,0 +1,92 @@
+//
+//  ShaderArchive.cpp
+//
+#include "ShaderArchive.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+================================================================================================
+
+ShaderArchive
+
+================================================================================================
+*/
+
+/*
+====================================================
+ShaderArchive::Open
+====================================================
+*/
+bool ShaderArchive::Open( const char * fileName ) {
+	Close();
+
+	if ( !MapFileData( fileName, m_file ) ) {
+		return false;
+	}
+
+	const header_t * header = (const header_t *)m_file.data;
+	if ( m_file.size < sizeof( header_t ) || MAGIC != header->magic || VERSION != header->version ) {
+		printf( "ERROR: %s is not a shader archive\n", fileName );
+		UnmapFileData( m_file );
+		return false;
+	}
+
+	// Make sure the whole manifest and all the code are in the file
+	const entry_t * entries = (const entry_t *)( m_file.data + sizeof( header_t ) );
+	const uint64_t manifestEnd = sizeof( header_t ) + (uint64_t)header->numEntries * sizeof( entry_t );
+	bool isValid = ( manifestEnd <= m_file.size );
+	for ( uint32_t i = 0; isValid && i < header->numEntries; i++ ) {
+		const entry_t & entry = entries[ i ];
+		isValid = ( (uint64_t)entry.offset + entry.size <= m_file.size ) && ( 0 == ( entry.offset & 3 ) ) && ( '\0' == entry.name[ MAX_NAME - 1 ] );
+	}
+	if ( !isValid ) {
+		printf( "ERROR: Shader archive %s is truncated or corrupted\n", fileName );
+		UnmapFileData( m_file );
+		return false;
+	}
+
+	m_header = header;
+	m_entries = entries;
+	return true;
+}
+
+/*
+====================================================
+ShaderArchive::Close
+====================================================
+*/
+void ShaderArchive::Close() {
+	if ( NULL == m_header ) {
+		return;
+	}
+
+	UnmapFileData( m_file );
+	m_header = NULL;
+	m_entries = NULL;
+}
+
+/*
+====================================================
+ShaderArchive::FindStage
+====================================================
+*/
+bool ShaderArchive::FindStage( const char * name, const int stage, const uint32_t ** code, int & size ) const {
+	if ( NULL == m_header ) {
+		return false;
+	}
+
+	// There are only a few dozen entries, a linear search is fine
+	for ( uint32_t i = 0; i < m_header->numEntries; i++ ) {
+		const entry_t & entry = m_entries[ i ];
+		if ( (uint32_t)stage != entry.stage || 0 != strcmp( entry.name, name ) ) {
+			continue;
+		}
+
+		*code = (const uint32_t *)( m_file.data + entry.offset );
+		size = (int)entry.size;
+		return true;
+	}
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+//
+//  ShaderArchive.h
+//
+#pragma once
+#include "../Fileio.h"
+#include <stdint.h>
+#include <string.h>
+
+/*
+================================================================================================
+
+ShaderArchive
+
+All the SPIR-V of the shaders packed in a single file by tools/pack_shaders.py.
+The file starts with a manifest of the stages available per shader, followed
+by the code of each stage. It's mapped in memory, so looking up a stage never
+touches the disk and the modules are created straight from the mapping.
+
+================================================================================================
+*/
+class ShaderArchive {
+public:
+	ShaderArchive() : m_header( NULL ), m_entries( NULL ) { memset( &m_file, 0, sizeof( m_file ) ); }
+	~ShaderArchive() {}
+
+	static const uint32_t MAGIC = 0x4b415053;	// "SPAK"
+	static const uint32_t VERSION = 1;
+	static const int MAX_NAME = 48;
+
+	struct header_t {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t numEntries;
+		uint32_t reserved;
+	};
+
+	// One per stage of a shader, the stage is a Shader::ShaderStage_t
+	struct entry_t {
+		char		name[ MAX_NAME ];
+		uint32_t	stage;
+		uint32_t	offset;	// from the start of the file, 4 bytes aligned
+		uint32_t	size;
+		uint32_t	reserved;
+	};
+
+	bool Open( const char * fileName );
+	void Close();
+	bool IsOpen() const { return NULL != m_header; }
+
+	// Safe to call from any thread while the archive is open
+	bool FindStage( const char * name, const int stage, const uint32_t ** code, int & size ) const;
+
+private:
+	mappedFile_t		m_file;
+	const header_t *	m_header;
+	const entry_t *		m_entries;
+};
\ No newline at end of file
@@ -0,0 +1,108 @@
+//
+//  StagingBuffer.cpp
+//
+#include "StagingBuffer.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+================================================================================================
+
+StagingBuffer
+
+================================================================================================
+*/
+
+/*
+====================================================
+StagingBuffer::Create
+====================================================
+*/
+bool StagingBuffer::Create( DeviceContext * device ) {
+	if ( !m_buffer.Allocate( device, NULL, STAGING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT ) ) {
+		printf( "ERROR: Failed to allocate staging buffer\n" );
+		assert( 0 );
+		return false;
+	}
+
+	// Host coherent, so it stays mapped for its whole life
+	m_mapped = (unsigned char *)m_buffer.MapBuffer( device );
+	m_offset = 0;
+	return true;
+}
+
+/*
+====================================================
+StagingBuffer::Cleanup
+====================================================
+*/
+void StagingBuffer::Cleanup( DeviceContext * device ) {
+	Flush( device );
+
+	m_buffer.UnmapBuffer( device );
+	m_buffer.Cleanup( device );
+	m_mapped = NULL;
+}
+
+/*
+====================================================
+StagingBuffer::Upload
+====================================================
+*/
+void StagingBuffer::Upload( DeviceContext * device, Buffer * dstBuffer, const void * data, int size ) {
+	const unsigned char * src = (const unsigned char *)data;
+
+	// Data bigger than the staging buffer goes in several pieces
+	int dstOffset = 0;
+	while ( dstOffset < size ) {
+		if ( m_offset >= STAGING_SIZE ) {
+			Flush( device );
+		}
+
+		int copySize = size - dstOffset;
+		if ( copySize > STAGING_SIZE - m_offset ) {
+			copySize = STAGING_SIZE - m_offset;
+		}
+
+		if ( VK_NULL_HANDLE == m_vkCommandBuffer ) {
+			m_vkCommandBuffer = device->CreateCommandBuffer( VK_COMMAND_BUFFER_LEVEL_PRIMARY );
+		}
+
+		memcpy( m_mapped + m_offset, src + dstOffset, copySize );
+
+		VkBufferCopy copyRegion = {};
+		copyRegion.srcOffset = m_offset;
+		copyRegion.dstOffset = dstOffset;
+		copyRegion.size = copySize;
+		vkCmdCopyBuffer( m_vkCommandBuffer, m_buffer.m_vkBuffer, dstBuffer->m_vkBuffer, 1, &copyRegion );
+
+		// Keep the next copy 16 byte aligned
+		m_offset = ( m_offset + copySize + 15 ) & ~15;
+		dstOffset += copySize;
+	}
+}
+
+/*
+====================================================
+StagingBuffer::Flush
+====================================================
+*/
+void StagingBuffer::Flush( DeviceContext * device ) {
+	if ( VK_NULL_HANDLE == m_vkCommandBuffer ) {
+		m_offset = 0;
+		return;
+	}
+
+	// Make the copies visible to the vertex input of any later submit
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+	vkCmdPipelineBarrier( m_vkCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+
+	// Waits for the copies, the staging memory is free again after this
+	device->FlushCommandBuffer( m_vkCommandBuffer, device->m_vkGraphicsQueue );
+	m_vkCommandBuffer = VK_NULL_HANDLE;
+	m_offset = 0;
+}
\ No newline at end of file
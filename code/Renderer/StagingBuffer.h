@@ -0,0 +1,41 @@
+//
+//  StagingBuffer.h
+//
+#pragma once
+#include "Buffer.h"
+
+/*
+================================================================================================
+
+StagingBuffer
+
+Uploads static data to device local buffers. The data is copied into a
+persistently mapped host buffer and a transfer command is recorded,
+all the copies pending are then submitted at once by Flush. A staging
+buffer that runs out of room is flushed early and reused.
+
+================================================================================================
+*/
+class StagingBuffer {
+public:
+	StagingBuffer() : m_mapped( NULL ), m_offset( 0 ), m_vkCommandBuffer( VK_NULL_HANDLE ) {}
+	~StagingBuffer() {}
+
+	static const int STAGING_SIZE = 4 * 1024 * 1024;
+
+	bool Create( DeviceContext * device );
+	void Cleanup( DeviceContext * device );
+
+	// The copy only happens on the next Flush, data can be released right away
+	void Upload( DeviceContext * device, Buffer * dstBuffer, const void * data, int size );
+
+	// Submits the pending copies and waits for them
+	void Flush( DeviceContext * device );
+
+private:
+	Buffer			m_buffer;
+	unsigned char *	m_mapped;
+	int				m_offset;	// first free byte of the staging buffer
+
+	VkCommandBuffer	m_vkCommandBuffer;	// recording while copies are pending
+};
\ No newline at end of file
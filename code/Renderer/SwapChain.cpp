@@ -27,9 +27,15 @@ SwapChain::Cleanup
 ====================================================
 */
 void SwapChain::Cleanup( DeviceContext * device ) {
-	// semaphores
-	vkDestroySemaphore( device->m_vkDevice, m_vkRenderFinishedSemaphore, nullptr );
-	vkDestroySemaphore( device->m_vkDevice, m_vkImageAvailableSemaphore, nullptr );
+	// semaphores and fences
+	for ( int i = 0; i < m_frameFences.size(); i++ ) {
+		vkDestroySemaphore( device->m_vkDevice, m_vkRenderFinishedSemaphores[ i ], nullptr );
+		vkDestroySemaphore( device->m_vkDevice, m_vkImageAvailableSemaphores[ i ], nullptr );
+		m_frameFences[ i ].Cleanup( device );
+	}
+	m_vkRenderFinishedSemaphores.clear();
+	m_vkImageAvailableSemaphores.clear();
+	m_frameFences.clear();
 
 	// depth buffer
 	vkDestroyImageView( device->m_vkDevice, m_vkDepthImageView, nullptr );
@@ -68,25 +74,36 @@ bool SwapChain::Create( DeviceContext * device, int width, int height ) {
 	m_vkExtent.height = height;
 
 	//
-	//	Create Semaphores
+	//	Create Semaphores and Fences, one set per frame in flight
 	//
 	{
 		VkSemaphoreCreateInfo semaphoreInfo = {};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		result = vkCreateSemaphore( device->m_vkDevice, &semaphoreInfo, nullptr, &m_vkImageAvailableSemaphore );
-		if ( VK_SUCCESS != result ) {
-			printf( "ERROR: Failed to create semaphores\n" );
-			assert( 0 );
-			return false;
-		}
+		m_vkImageAvailableSemaphores.resize( DeviceContext::MAX_FRAMES_IN_FLIGHT );
+		m_vkRenderFinishedSemaphores.resize( DeviceContext::MAX_FRAMES_IN_FLIGHT );
+		m_frameFences.resize( DeviceContext::MAX_FRAMES_IN_FLIGHT );
+		for ( int i = 0; i < DeviceContext::MAX_FRAMES_IN_FLIGHT; i++ ) {
+			result = vkCreateSemaphore( device->m_vkDevice, &semaphoreInfo, nullptr, &m_vkImageAvailableSemaphores[ i ] );
+			if ( VK_SUCCESS != result ) {
+				printf( "ERROR: Failed to create semaphores\n" );
+				assert( 0 );
+				return false;
+			}
 
-		result = vkCreateSemaphore( device->m_vkDevice, &semaphoreInfo, nullptr, &m_vkRenderFinishedSemaphore );
-		if ( VK_SUCCESS != result ) {
-			printf( "ERROR: Failed to create semaphores\n" );
-			assert( 0 );
-			return false;
+			result = vkCreateSemaphore( device->m_vkDevice, &semaphoreInfo, nullptr, &m_vkRenderFinishedSemaphores[ i ] );
+			if ( VK_SUCCESS != result ) {
+				printf( "ERROR: Failed to create semaphores\n" );
+				assert( 0 );
+				return false;
+			}
+
+			// Signaled, nothing to wait for the first time a frame index is used
+			if ( !m_frameFences[ i ].Create( device, true ) ) {
+				return false;
+			}
 		}
+		m_currentFrame = 0;
 	}
 
 	//
@@ -150,6 +167,7 @@ bool SwapChain::Create( DeviceContext * device, int width, int height ) {
 		vkGetSwapchainImagesKHR( device->m_vkDevice, m_vkSwapChain, &imageCount, nullptr );
 		m_vkColorImages.resize( imageCount );
 		vkGetSwapchainImagesKHR( device->m_vkDevice, m_vkSwapChain, &imageCount, m_vkColorImages.data() );
+		m_imageFrames.assign( imageCount, -1 );
 
 		m_vkColorImageFormat = surfaceFormat.format;
 	}
@@ -364,24 +382,44 @@ SwapChain::BeginFrame
 uint32_t SwapChain::BeginFrame( DeviceContext * device ) {
 	VkResult result;
 
+	m_currentFrame = device->m_frameIndex;
 	m_currentImageIndex = 0;
 
-	result = vkAcquireNextImageKHR( device->m_vkDevice, m_vkSwapChain, std::numeric_limits< uint64_t >::max(), m_vkImageAvailableSemaphore, VK_NULL_HANDLE, &m_currentImageIndex );
+	// The command buffer and the transient data of this frame index are free once its last submit is done,
+	// a heavy frame on a software device may take well over a second
+	bool isFrameFree = m_frameFences[ m_currentFrame ].Wait( device, std::numeric_limits< uint64_t >::max() );
+
+	result = vkAcquireNextImageKHR( device->m_vkDevice, m_vkSwapChain, std::numeric_limits< uint64_t >::max(), m_vkImageAvailableSemaphores[ m_currentFrame ], VK_NULL_HANDLE, &m_currentImageIndex );
 	if ( VK_SUCCESS != result && VK_SUBOPTIMAL_KHR != result ) {
 		printf( "ERROR: Failed to acquire swap chain image\n" );
 		assert( 0 );
 	}
 
+	// Images may come back out of order, wait for the frame still rendering to this one
+	const int imageFrame = m_imageFrames[ m_currentImageIndex ];
+	if ( imageFrame >= 0 && imageFrame != (int)m_currentFrame ) {
+		isFrameFree = m_frameFences[ imageFrame ].Wait( device, std::numeric_limits< uint64_t >::max() ) && isFrameFree;
+	}
+	m_imageFrames[ m_currentImageIndex ] = m_currentFrame;
+
+	// Never reset a fence still in flight, the device is lost anyway if the wait failed
+	if ( !isFrameFree ) {
+		printf( "ERROR: Failed to wait for the frame fences\n" );
+		assert( 0 );
+		return m_currentFrame;
+	}
+	m_frameFences[ m_currentFrame ].Reset( device );
+
 	// Reset the command buffer
-	vkResetCommandBuffer( device->m_vkCommandBuffers[ m_currentImageIndex ], VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT );
+	vkResetCommandBuffer( device->m_vkCommandBuffers[ m_currentFrame ], VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT );
 
 	// Begin recording draw commands
 	VkCommandBufferBeginInfo beginInfo = {};
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-	vkBeginCommandBuffer( device->m_vkCommandBuffers[ m_currentImageIndex ], &beginInfo );
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer( device->m_vkCommandBuffers[ m_currentFrame ], &beginInfo );
 
-	return m_currentImageIndex;
+	return m_currentFrame;
 }
 
 /*
@@ -392,7 +430,7 @@ SwapChain::EndFrame
 void SwapChain::EndFrame( DeviceContext * device ) {
 	VkResult result;
 
-	result = vkEndCommandBuffer( device->m_vkCommandBuffers[ m_currentImageIndex ] );
+	result = vkEndCommandBuffer( device->m_vkCommandBuffers[ m_currentFrame ] );
 	if ( VK_SUCCESS != result ) {
 		printf( "ERROR: Failed to record command buffer\n" );
 		assert( 0 );
@@ -405,14 +443,14 @@ void SwapChain::EndFrame( DeviceContext * device ) {
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = &m_vkImageAvailableSemaphore;
+	submitInfo.pWaitSemaphores = &m_vkImageAvailableSemaphores[ m_currentFrame ];
 	submitInfo.pWaitDstStageMask = waitStages;
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &device->m_vkCommandBuffers[ m_currentImageIndex ] ;
+	submitInfo.pCommandBuffers = &device->m_vkCommandBuffers[ m_currentFrame ];
 	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = &m_vkRenderFinishedSemaphore;
+	submitInfo.pSignalSemaphores = &m_vkRenderFinishedSemaphores[ m_currentFrame ];
 
-	result = vkQueueSubmit( device->m_vkGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE );
+	result = vkQueueSubmit( device->m_vkGraphicsQueue, 1, &submitInfo, m_frameFences[ m_currentFrame ].m_vkFence );
 	if ( VK_SUCCESS != result ) {
 		printf( "ERROR: Failed to submit queue\n" );
 		assert( 0 );
@@ -421,7 +459,7 @@ void SwapChain::EndFrame( DeviceContext * device ) {
 	VkPresentInfoKHR presentInfo = {};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	presentInfo.waitSemaphoreCount = 1;
-	presentInfo.pWaitSemaphores = &m_vkRenderFinishedSemaphore;
+	presentInfo.pWaitSemaphores = &m_vkRenderFinishedSemaphores[ m_currentFrame ];
 	presentInfo.swapchainCount = 1;
 	presentInfo.pSwapchains = &m_vkSwapChain;
 	presentInfo.pImageIndices = &m_currentImageIndex;
@@ -432,7 +470,7 @@ void SwapChain::EndFrame( DeviceContext * device ) {
 		assert( 0 );
 	}
 
-	vkQueueWaitIdle( device->m_vkPresentQueue );
+	// No wait here, the fence of this frame is checked the next time its index comes around
 }
 
 /*
@@ -457,7 +495,7 @@ void SwapChain::BeginRenderPass( DeviceContext * device ) {
 	renderPassInfo.clearValueCount = 2;
 	renderPassInfo.pClearValues = clearValues;
 
-	vkCmdBeginRenderPass( device->m_vkCommandBuffers[ m_currentImageIndex ], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
+	vkCmdBeginRenderPass( device->m_vkCommandBuffers[ m_currentFrame ], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
 
 	//
 	//	Set the viewport
@@ -469,14 +507,14 @@ void SwapChain::BeginRenderPass( DeviceContext * device ) {
 	viewport.height = (float)m_windowHeight;
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
-	vkCmdSetViewport( device->m_vkCommandBuffers[ m_currentImageIndex ], 0, 1, &viewport );
+	vkCmdSetViewport( device->m_vkCommandBuffers[ m_currentFrame ], 0, 1, &viewport );
 
 	VkRect2D scissor = {};
 	scissor.offset.x = 0;
 	scissor.offset.y = 0;
 	scissor.extent.width = m_windowWidth;
 	scissor.extent.height = m_windowHeight;
-	vkCmdSetScissor( device->m_vkCommandBuffers[ m_currentImageIndex ], 0, 1, &scissor );
+	vkCmdSetScissor( device->m_vkCommandBuffers[ m_currentFrame ], 0, 1, &scissor );
 }
 
 /*
@@ -485,5 +523,5 @@ SwapChain::EndRenderPass
 ====================================================
 */
 void SwapChain::EndRenderPass( DeviceContext * device ) {
-	vkCmdEndRenderPass( device->m_vkCommandBuffers[ m_currentImageIndex ] );
+	vkCmdEndRenderPass( device->m_vkCommandBuffers[ m_currentFrame ] );
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include <vector>
+#include "Fence.h"
 
 class DeviceContext;
 
@@ -18,14 +19,21 @@ public:
 	void Cleanup( DeviceContext * device );
 	void Resize( DeviceContext * device, int width, int height );
 
+	// Waits until the gpu is done with the previous use of the frame index,
+	// returns the index of the command buffer to record the frame into
 	uint32_t BeginFrame( DeviceContext * device );
 	void EndFrame( DeviceContext * device );
 
 	void BeginRenderPass( DeviceContext * device );
 	void EndRenderPass( DeviceContext * device );
 
-	VkSemaphore m_vkImageAvailableSemaphore;
-	VkSemaphore m_vkRenderFinishedSemaphore;
+	//
+	//	Per frame in flight
+	//
+	std::vector< VkSemaphore >	m_vkImageAvailableSemaphores;
+	std::vector< VkSemaphore >	m_vkRenderFinishedSemaphores;
+	std::vector< Fence >		m_frameFences;		// signaled when the gpu is done with the frame
+	uint32_t					m_currentFrame;		// frame index being recorded, also its command buffer
 
 	int m_windowWidth;
 	int m_windowHeight;
@@ -37,6 +45,7 @@ public:
 	VkFormat					m_vkColorImageFormat;
 	std::vector< VkImage >		m_vkColorImages;
 	std::vector< VkImageView >	m_vkImageViews;
+	std::vector< int >			m_imageFrames;		// frame index that last rendered to each image, -1 if none
 
 	VkFormat m_vkDepthFormat;
 	VkImage m_vkDepthImage;
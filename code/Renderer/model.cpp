@@ -342,10 +342,12 @@ void FillCubeTessellated(Model& model, int numDivisions) {
 
 /*
 ====================================================
-FillSphere
+GetSphereDivisions
+
+Tessellation of the finest lod, grows with the radius
 ====================================================
 */
-void FillSphere(Model& model, const float radius) {
+static int GetSphereDivisions(const float radius) {
 	float t = radius;
 	if (t < 0.0f) {
 		t = 0.0f;
@@ -357,7 +359,19 @@ void FillSphere(Model& model, const float radius) {
 	float min = 5;
 	float max = 30;
 	float s = min * (1.0f - t) + max * t;
-	FillCubeTessellated(model, (int)s);
+	return (int)s;
+}
+
+// Coarser lods halve the divisions until they would go under this
+static const int MIN_SPHERE_DIVISIONS = 2;
+
+/*
+====================================================
+FillSphere
+====================================================
+*/
+void FillSphere(Model& model, const float radius, const int lod) {
+	FillCubeTessellated(model, GetSphereDivisions(radius) >> lod);
 
 	// Project the tessellated cube onto a sphere
 	for (int i = 0; i < model.m_vertices.size(); i++) {
@@ -385,12 +399,32 @@ void FillSphere(Model& model, const float radius) {
 	}
 }
 
+/*
+====================================================
+Model::GetNumLods
+====================================================
+*/
+int Model::GetNumLods(const Shape* shape) {
+	if (NULL == shape || shape->GetType() != Shape::ShapeType::SHAPE_SPHERE) {
+		return 1;
+	}
+
+	const ShapeSphere* shapeSphere = (const ShapeSphere*)shape;
+	const int numDivisions = GetSphereDivisions(shapeSphere->radius);
+
+	int numLods = 1;
+	while (numLods < MAX_LODS && (numDivisions >> numLods) >= MIN_SPHERE_DIVISIONS) {
+		numLods++;
+	}
+	return numLods;
+}
+
 /*
 ====================================================
 Model::BuildFromShape
 ====================================================
 */
-bool Model::BuildFromShape(const Shape* shape) {
+bool Model::BuildFromShape(const Shape* shape, const int lod) {
 	if (NULL == shape) {
 		return false;
 	}
@@ -400,7 +434,7 @@ bool Model::BuildFromShape(const Shape* shape) {
 		m_vertices.clear();
 		m_indices.clear();
 
-		FillSphere(*this, shapeSphere->radius);
+		FillSphere(*this, shapeSphere->radius, lod);
 		for (int v = 0; v < m_vertices.size(); v++) {
 			for (int i = 0; i < 3; i++) {
 				m_vertices[v].xyz[i] *= shapeSphere->radius;
@@ -408,7 +442,6 @@ bool Model::BuildFromShape(const Shape* shape) {
 		}
 	}
 
-	/*
 	else if (shape->GetType() == Shape::ShapeType::SHAPE_BOX) {
 		const ShapeBox* shapeBox = (const ShapeBox*)shape;
 
@@ -416,8 +449,8 @@ bool Model::BuildFromShape(const Shape* shape) {
 		m_indices.clear();
 
 		FillCubeTessellated(*this, 0);
-		Vec3 halfdim = (shapeBox->m_bounds.maxs - shapeBox->m_bounds.mins) * 0.5f;
-		Vec3 center = (shapeBox->m_bounds.maxs + shapeBox->m_bounds.mins) * 0.5f;
+		Vec3 halfdim = (shapeBox->bounds.maxs - shapeBox->bounds.mins) * 0.5f;
+		Vec3 center = (shapeBox->bounds.maxs + shapeBox->bounds.mins) * 0.5f;
 		for (int v = 0; v < m_vertices.size(); v++) {
 			for (int i = 0; i < 3; i++) {
 				m_vertices[v].xyz[i] *= halfdim[i];
@@ -434,7 +467,7 @@ bool Model::BuildFromShape(const Shape* shape) {
 		// Build the connected convex hull from the points
 		std::vector< Vec3 > hullPts;
 		std::vector< tri_t > hullTris;
-		BuildConvexHull(shapeConvex->m_points, hullPts, hullTris);
+		BuildConvexHull(shapeConvex->points, hullPts, hullTris);
 
 		// Calculate smoothed normals
 		std::vector< Vec3 > normals;
@@ -488,7 +521,6 @@ bool Model::BuildFromShape(const Shape* shape) {
 			m_indices.push_back(hullTris[i].c);
 		}
 	}
-		*/
 	return true;
 
 	}
@@ -499,13 +531,11 @@ bool Model::BuildFromShape(const Shape* shape) {
 	================================
 	*/
 	bool Model::MakeVBO(DeviceContext * device) {
-		VkCommandBuffer vkCommandBuffer = device->m_vkCommandBuffers[0];
-
 		int bufferSize;
 
 		// Create Vertex Buffer
 		bufferSize = (int)(sizeof(m_vertices[0]) * m_vertices.size());
-		if (!m_vertexBuffer.Allocate(device, m_vertices.data(), bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)) {
+		if (!m_vertexBuffer.AllocateStatic(device, m_vertices.data(), bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)) {
 			printf("failed to allocate vertex buffer!\n");
 			assert(0);
 			return false;
@@ -513,7 +543,7 @@ bool Model::BuildFromShape(const Shape* shape) {
 
 		// Create Index Buffer
 		bufferSize = (int)(sizeof(m_indices[0]) * m_indices.size());
-		if (!m_indexBuffer.Allocate(device, m_indices.data(), bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+		if (!m_indexBuffer.AllocateStatic(device, m_indices.data(), bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
 			printf("failed to allocate index buffer!\n");
 			assert(0);
 			return false;
@@ -551,4 +581,20 @@ bool Model::BuildFromShape(const Shape* shape) {
 
 		// Issue draw command
 		vkCmdDrawIndexed(vkCommandBUffer, (uint32_t)m_indices.size(), 1, 0, 0, 0);
+	}
+
+	/*
+	====================================================
+	Model::DrawIndexedInstanced
+	====================================================
+	*/
+	void Model::DrawIndexedInstanced(VkCommandBuffer vkCommandBUffer, Buffer* instanceBuffer, int instanceByteOffset, uint32_t firstInstance, uint32_t numInstances) {
+		// Bind the model and the per instance matrices
+		VkBuffer vertexBuffers[] = { m_vertexBuffer.m_vkBuffer, instanceBuffer->m_vkBuffer };
+		VkDeviceSize offsets[] = { 0, (VkDeviceSize)instanceByteOffset };
+		vkCmdBindVertexBuffers(vkCommandBUffer, 0, 2, vertexBuffers, offsets);
+		vkCmdBindIndexBuffer(vkCommandBUffer, m_indexBuffer.m_vkBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+		// Issue draw command, gl_InstanceIndex starts at firstInstance
+		vkCmdDrawIndexed(vkCommandBUffer, (uint32_t)m_indices.size(), numInstances, 0, 0, firstInstance);
 	}
\ No newline at end of file
@@ -64,6 +64,41 @@ struct vert_t {
 	}
 };
 
+/*
+====================================================
+instance_t
+// 16 * 4 = 64 bytes - per instance model matrix, read from a second vertex buffer
+====================================================
+*/
+struct instance_t {
+	float			matModel[ 16 ];	// 64 bytes, already transposed, one column per attribute
+
+	static const uint32_t BINDING = 1;
+	static const uint32_t FIRST_LOCATION = 5;	// after the vert_t attributes
+
+	static VkVertexInputBindingDescription GetBindingDescription() {
+		VkVertexInputBindingDescription bindingDescription = {};
+		bindingDescription.binding = BINDING;
+		bindingDescription.stride = sizeof( instance_t );
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+		return bindingDescription;
+	}
+
+	static std::array< VkVertexInputAttributeDescription, 4 > GetAttributeDescriptions() {
+		std::array< VkVertexInputAttributeDescription, 4 > attributeDescriptions = {};
+
+		for ( uint32_t i = 0; i < 4; i++ ) {
+			attributeDescriptions[ i ].binding = BINDING;
+			attributeDescriptions[ i ].location = FIRST_LOCATION + i;
+			attributeDescriptions[ i ].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[ i ].offset = sizeof( float ) * 4 * i;
+		}
+
+		return attributeDescriptions;
+	}
+};
+
 class Shape;
 
 /*
@@ -79,7 +114,11 @@ public:
 	std::vector< vert_t > m_vertices;
 	std::vector< unsigned int > m_indices;
 
-	bool BuildFromShape( const Shape * shape );
+	// Lod 0 is the finest, each next one has about a quarter of the triangles.
+	// Only spheres have more than one lod, the other shapes ignore it.
+	static const int MAX_LODS = 4;
+	static int GetNumLods( const Shape * shape );
+	bool BuildFromShape( const Shape * shape, const int lod = 0 );
 	bool MakeVBO( DeviceContext * device );
 
 	// GPU Data
@@ -90,6 +129,7 @@ public:
 	void Cleanup( DeviceContext & deviceContext );
 
 	void DrawIndexed( VkCommandBuffer vkCommandBUffer );
+	void DrawIndexedInstanced( VkCommandBuffer vkCommandBUffer, Buffer * instanceBuffer, int instanceByteOffset, uint32_t firstInstance, uint32_t numInstances );
 };
 
 void FillCube( Model & model );
@@ -100,9 +140,16 @@ void FillFullScreenQuad( Model & model );
 
 struct RenderModel {
 	Model * model;			// The vao buffer to draw
+	Buffer * uniformBuffer;	// The uniform buffer holding the model matrix
 	uint32_t uboByteOffset;	// The byte offset into the uniform buffer
 	uint32_t uboByteSize;	// how much space we consume in the uniform buffer
 
 	Vec3 pos;
 	Quat orient;
+};
+
+struct RenderBatch {
+	Model * model;			// The mesh shared by all the instances
+	uint32_t firstInstance;	// The first instance_t, from the start of the frame instances
+	uint32_t numInstances;
 };
\ No newline at end of file
@@ -2,8 +2,11 @@
 //  shader.cpp
 //
 #include "shader.h"
+#include "ShaderArchive.h"
 #include "../Fileio.h"
+#include "../JobSystem.h"
 #include <assert.h>
+#include <stdlib.h>
 
 #include "model.h"
 
@@ -17,6 +20,9 @@ Shader
 ========================================================================================================
 */
 
+// Mapped while the shaders are loaded at startup
+static ShaderArchive g_shaderArchive;
+
 /*
 ====================================================
 Shader::Shader
@@ -26,12 +32,67 @@ Shader::Shader() {
 	memset( m_vkShaderModules, 0, sizeof( VkShaderModule ) * SHADER_STAGE_NUM );
 }
 
+/*
+====================================================
+Shader::OpenArchive
+====================================================
+*/
+bool Shader::OpenArchive( const char * fileName ) {
+	return g_shaderArchive.Open( fileName );
+}
+
+/*
+====================================================
+Shader::CloseArchive
+====================================================
+*/
+void Shader::CloseArchive() {
+	g_shaderArchive.Close();
+}
+
 /*
 ====================================================
 Shader::Load
 ====================================================
 */
-bool Shader::Load( DeviceContext * device, const char * name ) {
+bool Shader::Load( DeviceContext * device, const char * name, const char * baseName ) {
+	int numStagesLoaded = 0;
+	for ( int i = 0; i < SHADER_STAGE_NUM; i++ ) {
+		if ( LoadStage( device, name, i ) ) {
+			numStagesLoaded++;
+			continue;
+		}
+
+		// Then the stage shared with the base shader
+		if ( NULL != baseName ) {
+			LoadStage( device, baseName, i );
+		}
+	}
+
+	if ( 0 == numStagesLoaded ) {
+		Cleanup( device );
+		return false;
+	}
+	return true;
+}
+
+/*
+====================================================
+Shader::LoadStage
+====================================================
+*/
+bool Shader::LoadStage( DeviceContext * device, const char * name, const int stage ) {
+	// The manifest tells which stages exist, the code is read straight from the mapping
+	if ( g_shaderArchive.IsOpen() ) {
+		const uint32_t * code = NULL;
+		int size = 0;
+		if ( !g_shaderArchive.FindStage( name, stage, &code, size ) ) {
+			return false;
+		}
+		m_vkShaderModules[ stage ] = Shader::CreateShaderModule( device->m_vkDevice, (const char *)code, size );
+		return true;
+	}
+
 	const char * fileExtensions[ SHADER_STAGE_NUM ];
 	fileExtensions[ SHADER_STAGE_VERTEX ]					= "vert";
 	fileExtensions[ SHADER_STAGE_TESSELLATION_CONTROL ]		= "tess";
@@ -48,22 +109,37 @@ bool Shader::Load( DeviceContext * device, const char * name ) {
 	fileExtensions[ SHADER_STAGE_TASK ]						= "task";
 	fileExtensions[ SHADER_STAGE_MESH ]						= "mesh";
 
-	for ( int i = 0; i < SHADER_STAGE_NUM; i++ ) {
-		unsigned char * code = NULL;
-		unsigned int size = 0;
-
-		// Try loading the spirv code first
-		char nameSpirv[ 1024 ];
-		sprintf_s( nameSpirv, 1024, "data/shaders/spirv/%s.%s.spirv", name, fileExtensions[ i ] );
-		if ( GetFileData( nameSpirv, &code, size ) ) {
-			m_vkShaderModules[ i ] = Shader::CreateShaderModule( device->m_vkDevice, (char*)code, size );
-			continue;
-		}
+	unsigned char * code = NULL;
+	unsigned int size = 0;
+
+	char nameSpirv[ 1024 ];
+	sprintf_s( nameSpirv, 1024, "data/shaders/spirv/%s.%s.spirv", name, fileExtensions[ stage ] );
+	if ( !GetFileData( nameSpirv, &code, size ) ) {
+		return false;
 	}
 
+	// The driver keeps its own copy
+	m_vkShaderModules[ stage ] = Shader::CreateShaderModule( device->m_vkDevice, (char*)code, size );
+	free( code );
 	return true;
 }
 
+/*
+====================================================
+Shader::LoadShaders
+====================================================
+*/
+void Shader::LoadShaders( DeviceContext * device, JobSystem & jobSystem, LoadParms_t * shaders, const int num ) {
+	JobSystem::JobCounter counter( 0 );
+	for ( int i = 0; i < num; i++ ) {
+		LoadParms_t * parms = &shaders[ i ];
+		jobSystem.Submit( [device, parms] {
+				parms->isLoaded = parms->shader->Load( device, parms->name, parms->baseName );
+			}, &counter );
+	}
+	jobSystem.Wait( counter );
+}
+
 /*
 ====================================================
 Shader::Cleanup
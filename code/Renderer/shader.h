@@ -7,6 +7,8 @@
 #include "Descriptor.h"
 #include <vulkan/vulkan.h>
 
+class JobSystem;
+
 /*
 ====================================================
 Shader
@@ -37,10 +39,28 @@ public:
 	Shader();
 	~Shader() {}
 
-	bool Load( DeviceContext * device, const char * name );
+	// Stages with no spirv under name are taken from baseName, so variants only
+	// need the stages they replace. Fails when name itself has no stage at all.
+	bool Load( DeviceContext * device, const char * name, const char * baseName = NULL );
 	void Cleanup( DeviceContext * device );
 
+	struct LoadParms_t {
+		Shader *		shader;
+		const char *	name;
+		const char *	baseName;
+		bool			isLoaded;	// result of Load
+	};
+
+	// Loads the shaders concurrently, one job each
+	static void LoadShaders( DeviceContext * device, JobSystem & jobSystem, LoadParms_t * shaders, const int num );
+
+	// While the archive is open the stages come from it, otherwise every
+	// stage is probed as a separate file of data/shaders/spirv
+	static bool OpenArchive( const char * fileName );
+	static void CloseArchive();
+
 private:
+	bool LoadStage( DeviceContext * device, const char * name, const int stage );
 	static VkShaderModule CreateShaderModule( VkDevice vkDevice, const char * code, const int size );
 
 public:
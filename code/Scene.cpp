@@ -5,9 +5,12 @@
 #include "Shape.h"
 #include "Intersection.h"
 #include "Broadphase.h"
+#include "Narrowphase.h"
+#include "Island.h"
 #include "application.h"
 
 #include <algorithm>
+#include <assert.h>
 #include <random>
 
 
@@ -98,6 +101,12 @@ void Scene::Initialize()
 	bodyB.elasticity = 0.5f;
 	bodies.push_back( bodyB );*/
 
+#if !defined( NDEBUG )
+	//  the SIMD time of impact must match the scalar one
+	const int sphere_mismatches_count = CheckSphereToSphereHits( 20000, BENCHMARK_DT, 1 );
+	assert( sphere_mismatches_count == 0 );
+#endif
+
 	//  setup players
 	firstPlayerState.name = "Player 1";
 	firstPlayerState.score = 0;
@@ -218,27 +227,14 @@ void Scene::UpdatePhysics( const float dt )
 	}
 
 
-	//  collisions
-	std::vector<Contact> contacts;
-	contacts.reserve( bodies.size() * bodies.size() );
-
 	//  broadphase
 	std::vector<CollisionPair> collisions_pairs;
 	Broadphase( bodies, collisions_pairs, dt );
-	for ( int i = 0; i < collisions_pairs.size(); i++ )
-	{
-		const CollisionPair& pair = collisions_pairs[i];
-		Body& a = bodies[pair.a];
-		Body& b = bodies[pair.b];
-
-		if ( a.IsStatic() && b.IsStatic() ) continue;
 
-		Contact contact;
-		if ( Intersection::Intersect( a, b, dt, contact ) )
-		{
-			contacts.push_back( contact );
-		}
-	}
+	//  collisions
+	std::vector<Contact> contacts;
+	contacts.reserve( collisions_pairs.size() );
+	Narrowphase( bodies, collisions_pairs, dt, contactMode, pairCaches, contacts );
 	/*for ( int i = 0; i < bodies.size(); i++ )
 	{
 		Body& a = bodies[i];
@@ -256,34 +252,123 @@ void Scene::UpdatePhysics( const float dt )
 		}
 	}*/
 
-	std::sort( contacts.begin(), contacts.end(), Contact::Compare );
+	//  split contacts into independent islands and solve them concurrently
+	BuildIslands( bodies, contacts, islands );
+	SolveIslands( dt );
+}
 
-	float accumulated_time = 0.0f;
-	for ( Contact& contact : contacts )
-	{
-		const float local_dt = contact.impactTime - accumulated_time;
+/*
+====================================================
+Scene::SolveIslands
+====================================================
+*/
+void Scene::SolveIslands( const float dt )
+{
+	//  biggest islands first so they don't end up last on a single thread
+	std::sort( islands.begin(), islands.end(), Island::CompareWorkSize );
 
-		//  position
-		for ( Body& body : bodies )
+	const int count = (int) islands.size();
+	int i = 0;
+	while ( i < count )
+	{
+		//  batch small islands together, a job per lonely ball would cost more than solving it
+		const int begin = i;
+		int work_size = 0;
+		do
 		{
-			if ( body.IsStatic() ) continue;
-			body.Update( local_dt );
-		}
+			work_size += islands[i].GetWorkSize();
+			i++;
+		} while ( i < count && work_size < ISLANDS_BATCH_WORK_SIZE );
 
-		contact.Resolve();
-		accumulated_time += local_dt;
+		const int end = i;
+		jobSystem.Submit( [this, begin, end, dt]
+			{
+				for ( int j = begin; j < end; j++ )
+				{
+					islands[j].Solve( bodies, dt, contactMode, jobSystem );
+				}
+			} );
 	}
 
-	//  update position depending on remaining time	
-	const float time_remaining = dt - accumulated_time;
-	if ( time_remaining > 0.0f )
+	jobSystem.Wait();
+}
+
+/*
+====================================================
+Scene::BenchmarkTunnelling
+
+Throws the target at MAX_SHOOT_FORCE all around, once per
+contact mode, from a copy of the current bodies. Counts the
+throws ending inside the earth or through the walls.
+====================================================
+*/
+void Scene::BenchmarkTunnelling()
+{
+	if ( target == nullptr ) return;
+
+	//  same size, so the assignments below keep the pointers into bodies valid
+	const std::vector<Body> saved_bodies = bodies;
+	const ContactMode saved_contact_mode = contactMode;
+	const int target_id = (int) ( target - bodies.data() );
+
+	const float PI = 3.14159265359f;
+	const ContactMode modes[] = { ContactMode::TimeOfImpact, ContactMode::Speculative };
+	const char* modes_names[] = { "TimeOfImpact", "Speculative" };
+	for ( int m = 0; m < 2; m++ )
 	{
-		for ( Body& body : bodies )
+		contactMode = modes[m];
+
+		int tunnelled_count = 0;
+		int steps_count = 0;
+		int physics_time = 0;
+		for ( int i = 0; i < BENCHMARK_THROWS; i++ )
 		{
-			if ( body.IsStatic() ) continue;
-			body.Update( time_remaining );
+			bodies = saved_bodies;
+			pairCaches = PairCaches();
+
+			//  shoot a bit upper, as Shoot does
+			const float angle = 2.0f * PI * i / BENCHMARK_THROWS;
+			Vec3 dir( cosf( angle ), sinf( angle ), 0.1f );
+			dir.Normalize();
+
+			Body& ball = bodies[target_id];
+			ball.linearVelocity.Zero();
+			ball.angularVelocity.Zero();
+			ball.ApplyLinearImpulse( dir * MAX_SHOOT_FORCE );
+
+			for ( int step = 0; step < BENCHMARK_STEPS; step++ )
+			{
+				const int start_time = GetTimeMicroseconds();
+				UpdatePhysics( BENCHMARK_DT );
+				physics_time += GetTimeMicroseconds() - start_time;
+				steps_count++;
+
+				if ( IsTunnelled( ball ) )
+				{
+					tunnelled_count++;
+					break;
+				}
+			}
 		}
+
+		printf( "Tunnelling Benchmark: %s | Tunnelled: %d/%d | Step: %.3fms\n",
+			modes_names[m], tunnelled_count, BENCHMARK_THROWS, physics_time * 0.001f / steps_count );
 	}
+
+	bodies = saved_bodies;
+	contactMode = saved_contact_mode;
+	pairCaches = PairCaches();
+}
+
+bool Scene::IsTunnelled( const Body& body ) const
+{
+	//  center under the ground
+	if ( ( body.position - earth.position ).GetLengthSqr() < EARTH_RADIUS * EARTH_RADIUS ) return true;
+
+	//  out of the walls without flying over them
+	const float horizontal_distance_sqr = body.position.x * body.position.x + body.position.y * body.position.y;
+	return horizontal_distance_sqr > WALLS_POSITION_RADIUS * WALLS_POSITION_RADIUS
+		&& body.position.z < WALLS_Z + WALLS_RADIUS;
 }
 
 void Scene::OnKeyInput( int key, int action )
@@ -303,6 +388,18 @@ void Scene::OnKeyInput( int key, int action )
 			Shoot();
 		}
 	}
+	//  contact mode inputs
+	else if ( key == CONTACT_MODE_KEY && action == GLFW_RELEASE )
+	{
+		contactMode = contactMode == ContactMode::TimeOfImpact ? ContactMode::Speculative : ContactMode::TimeOfImpact;
+		pairCaches = PairCaches();
+
+		printf( "ContactMode: %s\n", contactMode == ContactMode::TimeOfImpact ? "TimeOfImpact" : "Speculative" );
+	}
+	else if ( key == BENCHMARK_KEY && action == GLFW_RELEASE )
+	{
+		BenchmarkTunnelling();
+	}
 }
 
 Body& Scene::SpawnSphere( const Vec3& pos, SphereSettings settings )
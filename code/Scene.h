@@ -7,6 +7,9 @@
 
 #include "Body.h"
 #include "Camera.h"
+#include "Island.h"
+#include "JobSystem.h"
+#include "Narrowphase.h"
 
 #include <GLFW/glfw3.h>
 
@@ -76,14 +79,20 @@ public:
 
 	void OnKeyInput( int key, int action );
 
+	Camera& GetCamera() { return camera; }
+
 	std::vector<Body> bodies;
 
 private:
 	Application* application;
 
+	JobSystem jobSystem;
+	std::vector<Island> islands;
+	PairCaches pairCaches;
+
 	Body earth;
 	Body* target { nullptr };
-	Camera& camera;
+	Camera camera;	//  own copy, the scene may run on another thread than the renderer
 
 	//  world settings
 	const float EARTH_RADIUS = 500.0f;		//  radius of the earth, don't mess with it unless you want to mess with the walls generation
@@ -97,6 +106,8 @@ private:
 	//  game settings
 	const float GRAVITY_SCALE = 50.0f;		//  gravity force
 	const int SHOOT_KEY = GLFW_KEY_SPACE;	//  user input for shooting
+	const int CONTACT_MODE_KEY = GLFW_KEY_C;	//  user input for switching between contact modes
+	const int BENCHMARK_KEY = GLFW_KEY_B;	//  user input for running the tunnelling benchmark
 	const float MAX_SHOOT_TIME = 1.0f;		//  maximum time of user holding the shoot key
 	const float MAX_SHOOT_FORCE = 75.0f;	//  maximum user shoot force, scaled w/ shoot time
 	const float MAX_TIME_TO_END = 2.0f;		//  maximum time after shooting before turn is ended
@@ -105,6 +116,15 @@ private:
 	SphereSettings piggyBallSettings;		//  physics settings for the piggy, see SetupSettings function below
 	SphereSettings metalBallSettings;		//  physics settings for a player ball, see SetupSettings function below
 
+	//  physics settings
+	const int ISLANDS_BATCH_WORK_SIZE = 64;	//  minimum bodies & contacts count solved by a single job
+	ContactMode contactMode = ContactMode::TimeOfImpact;	//  how continuous collisions are turned into contacts
+
+	//  tunnelling benchmark settings
+	const int BENCHMARK_THROWS = 36;		//  throws per contact mode, spread around the target
+	const int BENCHMARK_STEPS = 120;		//  physics steps simulated after each throw
+	const float BENCHMARK_DT = 1.0f / 60.0f;
+
 	void SetupSettings()
 	{
 		piggyBallSettings.mass = 1.0f;
@@ -137,6 +157,10 @@ private:
 
 	void SortBallsPerProximity();
 
+	void SolveIslands( const float dt );
+	void BenchmarkTunnelling();
+	bool IsTunnelled( const Body& body ) const;
+
 	//  game states
 	void BeginSet();
 	void EndSet();
@@ -0,0 +1,445 @@
+#include "Shape.h"
+
+#include <algorithm>
+
+//  samples per axis when integrating the convex hulls volume
+const int CONVEX_VOLUME_SAMPLES = 32;
+
+/*
+====================================================
+ShapeBox
+====================================================
+*/
+ShapeBox::ShapeBox( const Vec3* _points, const int count )
+{
+	for ( int i = 0; i < count; i++ )
+	{
+		bounds.Expand( _points[i] );
+	}
+
+	points[0] = Vec3( bounds.mins.x, bounds.mins.y, bounds.mins.z );
+	points[1] = Vec3( bounds.maxs.x, bounds.mins.y, bounds.mins.z );
+	points[2] = Vec3( bounds.mins.x, bounds.maxs.y, bounds.mins.z );
+	points[3] = Vec3( bounds.mins.x, bounds.mins.y, bounds.maxs.z );
+	points[4] = Vec3( bounds.maxs.x, bounds.maxs.y, bounds.maxs.z );
+	points[5] = Vec3( bounds.mins.x, bounds.maxs.y, bounds.maxs.z );
+	points[6] = Vec3( bounds.maxs.x, bounds.mins.y, bounds.maxs.z );
+	points[7] = Vec3( bounds.maxs.x, bounds.maxs.y, bounds.mins.z );
+
+	massCenter = ( bounds.maxs + bounds.mins ) * 0.5f;
+}
+
+Mat3 ShapeBox::GetInertiaTensor() const
+{
+	//  solid box around its mass center
+	const float dx = bounds.WidthX();
+	const float dy = bounds.WidthY();
+	const float dz = bounds.WidthZ();
+
+	Mat3 tensor;
+	tensor.Zero();
+	tensor.rows[0][0] = ( dy * dy + dz * dz ) / 12.0f;
+	tensor.rows[1][1] = ( dx * dx + dz * dz ) / 12.0f;
+	tensor.rows[2][2] = ( dx * dx + dy * dy ) / 12.0f;
+	return tensor;
+}
+
+Bounds ShapeBox::GetBounds( const Vec3& pos, const Quat& orient ) const
+{
+	Bounds tmp;
+	for ( int i = 0; i < 8; i++ )
+	{
+		tmp.Expand( orient.RotatePoint( points[i] ) + pos );
+	}
+	return tmp;
+}
+
+Vec3 ShapeBox::Support( const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias ) const
+{
+	Vec3 max_point = orient.RotatePoint( points[0] ) + pos;
+	float max_distance = dir.Dot( max_point );
+	for ( int i = 1; i < 8; i++ )
+	{
+		const Vec3 point = orient.RotatePoint( points[i] ) + pos;
+		const float distance = dir.Dot( point );
+		if ( distance > max_distance )
+		{
+			max_distance = distance;
+			max_point = point;
+		}
+	}
+
+	Vec3 norm = dir;
+	norm.Normalize();
+	return max_point + norm * bias;
+}
+
+float ShapeBox::FastestLinearSpeed( const Vec3& angular_velocity, const Vec3& dir ) const
+{
+	float max_speed = 0.0f;
+	for ( int i = 0; i < 8; i++ )
+	{
+		const Vec3 r = points[i] - massCenter;
+		const float speed = dir.Dot( angular_velocity.Cross( r ) );
+		max_speed = std::max( max_speed, speed );
+	}
+	return max_speed;
+}
+
+/*
+====================================================
+ConvexHull
+====================================================
+*/
+static int FindPointFurthestInDir( const Vec3* points, const int count, const Vec3& dir )
+{
+	int max_id = 0;
+	float max_distance = dir.Dot( points[0] );
+	for ( int i = 1; i < count; i++ )
+	{
+		const float distance = dir.Dot( points[i] );
+		if ( distance > max_distance )
+		{
+			max_distance = distance;
+			max_id = i;
+		}
+	}
+	return max_id;
+}
+
+static float DistanceFromLine( const Vec3& a, const Vec3& b, const Vec3& point )
+{
+	Vec3 ab = b - a;
+	ab.Normalize();
+
+	const Vec3 ray = point - a;
+	const Vec3 projection = ab * ray.Dot( ab );
+	const Vec3 perpendicular = ray - projection;
+	return perpendicular.GetMagnitude();
+}
+
+static Vec3 FindPointFurthestFromLine( const Vec3* points, const int count, const Vec3& a, const Vec3& b )
+{
+	int max_id = 0;
+	float max_distance = DistanceFromLine( a, b, points[0] );
+	for ( int i = 1; i < count; i++ )
+	{
+		const float distance = DistanceFromLine( a, b, points[i] );
+		if ( distance > max_distance )
+		{
+			max_distance = distance;
+			max_id = i;
+		}
+	}
+	return points[max_id];
+}
+
+static float DistanceFromTriangle( const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& point )
+{
+	Vec3 normal = ( b - a ).Cross( c - a );
+	normal.Normalize();
+	return ( point - a ).Dot( normal );
+}
+
+static Vec3 FindPointFurthestFromTriangle( const Vec3* points, const int count, const Vec3& a, const Vec3& b, const Vec3& c )
+{
+	int max_id = 0;
+	float max_distance = DistanceFromTriangle( a, b, c, points[0] );
+	max_distance *= max_distance;
+	for ( int i = 1; i < count; i++ )
+	{
+		const float distance = DistanceFromTriangle( a, b, c, points[i] );
+		if ( distance * distance > max_distance )
+		{
+			max_distance = distance * distance;
+			max_id = i;
+		}
+	}
+	return points[max_id];
+}
+
+static void BuildTetrahedron( const Vec3* verts, const int count, std::vector<Vec3>& hull_points, std::vector<tri_t>& hull_tris )
+{
+	hull_points.clear();
+	hull_tris.clear();
+
+	Vec3 points[4];
+	points[0] = verts[FindPointFurthestInDir( verts, count, Vec3( 1.0f, 0.0f, 0.0f ) )];
+	points[1] = verts[FindPointFurthestInDir( verts, count, points[0] * -1.0f )];
+	points[2] = FindPointFurthestFromLine( verts, count, points[0], points[1] );
+	points[3] = FindPointFurthestFromTriangle( verts, count, points[0], points[1], points[2] );
+
+	//  keep the triangles counter-clockwise
+	if ( DistanceFromTriangle( points[0], points[1], points[2], points[3] ) > 0.0f )
+	{
+		std::swap( points[0], points[1] );
+	}
+
+	for ( int i = 0; i < 4; i++ )
+	{
+		hull_points.push_back( points[i] );
+	}
+
+	hull_tris.push_back( { 0, 1, 2 } );
+	hull_tris.push_back( { 0, 2, 3 } );
+	hull_tris.push_back( { 2, 1, 3 } );
+	hull_tris.push_back( { 1, 0, 3 } );
+}
+
+static void RemoveInternalPoints( const std::vector<Vec3>& hull_points, const std::vector<tri_t>& hull_tris, std::vector<Vec3>& check_points )
+{
+	for ( int i = 0; i < (int) check_points.size(); i++ )
+	{
+		const Vec3& point = check_points[i];
+
+		bool is_external = false;
+		for ( const tri_t& tri : hull_tris )
+		{
+			if ( DistanceFromTriangle( hull_points[tri.a], hull_points[tri.b], hull_points[tri.c], point ) > 0.0f )
+			{
+				is_external = true;
+				break;
+			}
+		}
+
+		//  also drop points too close to the hull ones
+		bool is_too_close = false;
+		for ( const Vec3& hull_point : hull_points )
+		{
+			if ( ( hull_point - point ).GetLengthSqr() < 0.01f * 0.01f )
+			{
+				is_too_close = true;
+				break;
+			}
+		}
+
+		if ( !is_external || is_too_close )
+		{
+			check_points.erase( check_points.begin() + i );
+			i--;
+		}
+	}
+}
+
+static bool IsEdgeUnique( const std::vector<tri_t>& tris, const std::vector<int>& facing_tris, const int ignored_tri, const edge_t& edge )
+{
+	for ( int tri_id : facing_tris )
+	{
+		if ( tri_id == ignored_tri ) continue;
+
+		const tri_t& tri = tris[tri_id];
+		const edge_t edges[3] = { { tri.a, tri.b }, { tri.b, tri.c }, { tri.c, tri.a } };
+		for ( int e = 0; e < 3; e++ )
+		{
+			if ( edge == edges[e] ) return false;
+		}
+	}
+	return true;
+}
+
+static void AddPoint( std::vector<Vec3>& hull_points, std::vector<tri_t>& hull_tris, const Vec3& point )
+{
+	//  triangles facing the point, in descending order so they can be erased one by one
+	std::vector<int> facing_tris;
+	for ( int i = (int) hull_tris.size() - 1; i >= 0; i-- )
+	{
+		const tri_t& tri = hull_tris[i];
+		if ( DistanceFromTriangle( hull_points[tri.a], hull_points[tri.b], hull_points[tri.c], point ) > 0.0f )
+		{
+			facing_tris.push_back( i );
+		}
+	}
+
+	//  edges on the border of the facing triangles
+	std::vector<edge_t> unique_edges;
+	for ( int tri_id : facing_tris )
+	{
+		const tri_t& tri = hull_tris[tri_id];
+		const edge_t edges[3] = { { tri.a, tri.b }, { tri.b, tri.c }, { tri.c, tri.a } };
+		for ( int e = 0; e < 3; e++ )
+		{
+			if ( IsEdgeUnique( hull_tris, facing_tris, tri_id, edges[e] ) )
+			{
+				unique_edges.push_back( edges[e] );
+			}
+		}
+	}
+
+	for ( int tri_id : facing_tris )
+	{
+		hull_tris.erase( hull_tris.begin() + tri_id );
+	}
+
+	//  close the hole with the new point
+	hull_points.push_back( point );
+	const int point_id = (int) hull_points.size() - 1;
+	for ( const edge_t& edge : unique_edges )
+	{
+		hull_tris.push_back( { edge.a, edge.b, point_id } );
+	}
+}
+
+static void RemoveUnreferencedVerts( std::vector<Vec3>& hull_points, std::vector<tri_t>& hull_tris )
+{
+	for ( int i = 0; i < (int) hull_points.size(); i++ )
+	{
+		bool is_used = false;
+		for ( const tri_t& tri : hull_tris )
+		{
+			if ( tri.a == i || tri.b == i || tri.c == i )
+			{
+				is_used = true;
+				break;
+			}
+		}
+		if ( is_used ) continue;
+
+		for ( tri_t& tri : hull_tris )
+		{
+			if ( tri.a > i ) tri.a--;
+			if ( tri.b > i ) tri.b--;
+			if ( tri.c > i ) tri.c--;
+		}
+
+		hull_points.erase( hull_points.begin() + i );
+		i--;
+	}
+}
+
+void BuildConvexHull( const std::vector<Vec3>& verts, std::vector<Vec3>& hull_points, std::vector<tri_t>& hull_tris )
+{
+	if ( verts.size() < 4 ) return;
+
+	BuildTetrahedron( verts.data(), (int) verts.size(), hull_points, hull_tris );
+
+	//  grow the hull with the furthest external point until none is left
+	std::vector<Vec3> external_verts = verts;
+	RemoveInternalPoints( hull_points, hull_tris, external_verts );
+	while ( !external_verts.empty() )
+	{
+		const int point_id = FindPointFurthestInDir( external_verts.data(), (int) external_verts.size(), external_verts[0] );
+		const Vec3 point = external_verts[point_id];
+		external_verts.erase( external_verts.begin() + point_id );
+
+		AddPoint( hull_points, hull_tris, point );
+		RemoveInternalPoints( hull_points, hull_tris, external_verts );
+	}
+
+	RemoveUnreferencedVerts( hull_points, hull_tris );
+}
+
+static bool IsExternal( const std::vector<Vec3>& points, const std::vector<tri_t>& tris, const Vec3& point )
+{
+	for ( const tri_t& tri : tris )
+	{
+		if ( DistanceFromTriangle( points[tri.a], points[tri.b], points[tri.c], point ) > 0.0f ) return true;
+	}
+	return false;
+}
+
+/*
+====================================================
+ShapeConvex
+====================================================
+*/
+ShapeConvex::ShapeConvex( const Vec3* _points, const int count )
+{
+	std::vector<Vec3> verts( _points, _points + count );
+	std::vector<tri_t> hull_tris;
+	BuildConvexHull( verts, points, hull_tris );
+
+	bounds.Expand( points.data(), (int) points.size() );
+
+	//  integrate mass center & inertia over a grid of samples inside the hull
+	const Vec3 step = ( bounds.maxs - bounds.mins ) / (float) CONVEX_VOLUME_SAMPLES;
+	std::vector<Vec3> samples;
+	for ( int x = 0; x < CONVEX_VOLUME_SAMPLES; x++ )
+	{
+		for ( int y = 0; y < CONVEX_VOLUME_SAMPLES; y++ )
+		{
+			for ( int z = 0; z < CONVEX_VOLUME_SAMPLES; z++ )
+			{
+				const Vec3 sample = bounds.mins + Vec3( step.x * ( x + 0.5f ), step.y * ( y + 0.5f ), step.z * ( z + 0.5f ) );
+				if ( IsExternal( points, hull_tris, sample ) ) continue;
+
+				samples.push_back( sample );
+			}
+		}
+	}
+
+	massCenter = Vec3( 0.0f );
+	for ( const Vec3& sample : samples )
+	{
+		massCenter += sample;
+	}
+	massCenter /= (float) std::max( (int) samples.size(), 1 );
+
+	inertiaTensor.Zero();
+	for ( const Vec3& sample : samples )
+	{
+		const Vec3 r = sample - massCenter;
+		inertiaTensor.rows[0][0] += r.y * r.y + r.z * r.z;
+		inertiaTensor.rows[1][1] += r.z * r.z + r.x * r.x;
+		inertiaTensor.rows[2][2] += r.x * r.x + r.y * r.y;
+
+		inertiaTensor.rows[0][1] -= r.x * r.y;
+		inertiaTensor.rows[0][2] -= r.x * r.z;
+		inertiaTensor.rows[1][2] -= r.y * r.z;
+		inertiaTensor.rows[1][0] -= r.x * r.y;
+		inertiaTensor.rows[2][0] -= r.x * r.z;
+		inertiaTensor.rows[2][1] -= r.y * r.z;
+	}
+	inertiaTensor *= 1.0f / (float) std::max( (int) samples.size(), 1 );
+}
+
+Bounds ShapeConvex::GetBounds( const Vec3& pos, const Quat& orient ) const
+{
+	Vec3 corners[8];
+	corners[0] = Vec3( bounds.mins.x, bounds.mins.y, bounds.mins.z );
+	corners[1] = Vec3( bounds.mins.x, bounds.mins.y, bounds.maxs.z );
+	corners[2] = Vec3( bounds.mins.x, bounds.maxs.y, bounds.mins.z );
+	corners[3] = Vec3( bounds.maxs.x, bounds.mins.y, bounds.mins.z );
+	corners[4] = Vec3( bounds.maxs.x, bounds.maxs.y, bounds.maxs.z );
+	corners[5] = Vec3( bounds.maxs.x, bounds.maxs.y, bounds.mins.z );
+	corners[6] = Vec3( bounds.maxs.x, bounds.mins.y, bounds.maxs.z );
+	corners[7] = Vec3( bounds.mins.x, bounds.maxs.y, bounds.maxs.z );
+
+	Bounds tmp;
+	for ( int i = 0; i < 8; i++ )
+	{
+		tmp.Expand( orient.RotatePoint( corners[i] ) + pos );
+	}
+	return tmp;
+}
+
+Vec3 ShapeConvex::Support( const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias ) const
+{
+	Vec3 max_point = orient.RotatePoint( points[0] ) + pos;
+	float max_distance = dir.Dot( max_point );
+	for ( int i = 1; i < (int) points.size(); i++ )
+	{
+		const Vec3 point = orient.RotatePoint( points[i] ) + pos;
+		const float distance = dir.Dot( point );
+		if ( distance > max_distance )
+		{
+			max_distance = distance;
+			max_point = point;
+		}
+	}
+
+	Vec3 norm = dir;
+	norm.Normalize();
+	return max_point + norm * bias;
+}
+
+float ShapeConvex::FastestLinearSpeed( const Vec3& angular_velocity, const Vec3& dir ) const
+{
+	float max_speed = 0.0f;
+	for ( const Vec3& point : points )
+	{
+		const Vec3 r = point - massCenter;
+		const float speed = dir.Dot( angular_velocity.Cross( r ) );
+		max_speed = std::max( max_speed, speed );
+	}
+	return max_speed;
+}
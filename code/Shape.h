@@ -1,7 +1,31 @@
 #pragma once
 
+#include <vector>
+
 #include "Math/Vector.h"
 #include "Math/Bounds.h"
+#include "Math/Quat.h"
+
+struct tri_t
+{
+	int a;
+	int b;
+	int c;
+};
+
+struct edge_t
+{
+	int a;
+	int b;
+
+	bool operator==( const edge_t& rhs ) const
+	{
+		return ( a == rhs.a && b == rhs.b ) || ( a == rhs.b && b == rhs.a );
+	}
+};
+
+//  connected convex hull of a points cloud, used by ShapeConvex & its model
+void BuildConvexHull( const std::vector<Vec3>& verts, std::vector<Vec3>& hull_points, std::vector<tri_t>& hull_tris );
 
 class Shape 
 {
@@ -9,8 +33,14 @@ public:
 	enum class ShapeType
 	{
 		SHAPE_SPHERE,
+		SHAPE_BOX,
+		SHAPE_CONVEX,
+		SHAPE_NUM,	//  shapes count, keep it last
 	};
 
+	//  shapes are deleted through Shape*, see Scene::Clean
+	virtual ~Shape() {}
+
 	Vec3 GetMassCenter() const { return massCenter; }
 	
 	virtual ShapeType GetType() const = 0;
@@ -19,6 +49,11 @@ public:
 	virtual Bounds GetBounds( const Vec3& pos, const Quat& orient ) const = 0;
 	virtual Bounds GetBounds() const = 0;
 
+	//  furthest world point in the direction, inflated by bias
+	virtual Vec3 Support( const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias ) const = 0;
+	//  fastest speed of a point of the shape along the direction, due to rotation
+	virtual float FastestLinearSpeed( const Vec3& angular_velocity, const Vec3& dir ) const { return 0.0f; }
+
 protected:
 	Vec3 massCenter;
 };
@@ -60,6 +95,48 @@ public:
 		return tmp;
 	}
 
+	Vec3 Support( const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias ) const override
+	{
+		return pos + dir * ( radius + bias );
+	}
+
 	float radius;
 };
 
+class ShapeBox : public Shape
+{
+public:
+	ShapeBox( const Vec3* points, const int count );
+
+	ShapeType GetType() const override { return ShapeType::SHAPE_BOX; }
+	Mat3 GetInertiaTensor() const override;
+
+	Bounds GetBounds( const Vec3& pos, const Quat& orient ) const override;
+	Bounds GetBounds() const override { return bounds; }
+
+	Vec3 Support( const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias ) const override;
+	float FastestLinearSpeed( const Vec3& angular_velocity, const Vec3& dir ) const override;
+
+	Vec3 points[8];
+	Bounds bounds;
+};
+
+class ShapeConvex : public Shape
+{
+public:
+	ShapeConvex( const Vec3* points, const int count );
+
+	ShapeType GetType() const override { return ShapeType::SHAPE_CONVEX; }
+	Mat3 GetInertiaTensor() const override { return inertiaTensor; }
+
+	Bounds GetBounds( const Vec3& pos, const Quat& orient ) const override;
+	Bounds GetBounds() const override { return bounds; }
+
+	Vec3 Support( const Vec3& dir, const Vec3& pos, const Quat& orient, const float bias ) const override;
+	float FastestLinearSpeed( const Vec3& angular_velocity, const Vec3& dir ) const override;
+
+	std::vector<Vec3> points;	//  hull points only
+	Bounds bounds;
+	Mat3 inertiaTensor;
+};
+
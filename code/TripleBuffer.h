@@ -0,0 +1,48 @@
+//
+//  TripleBuffer.h
+//
+#pragma once
+#include <atomic>
+
+/*
+====================================================
+TripleBuffer
+
+Lock-free hand-over of values from one writer thread to one
+reader thread. The writer fills its back slot and swaps it
+with the middle one, the reader swaps the middle slot with
+its front one only when a newer value was published. None
+of them ever waits for the other, the reader just keeps
+the last value it got.
+====================================================
+*/
+template <typename T>
+class TripleBuffer
+{
+public:
+	//  writer side, the slot to fill before Publish
+	T& GetBack() { return slots[backId]; }
+	void Publish()
+	{
+		backId = middle.exchange( backId | DIRTY_BIT, std::memory_order_acq_rel ) & ID_MASK;
+	}
+
+	//  reader side, the newest published value, stable until the next call
+	const T& Acquire()
+	{
+		if ( middle.load( std::memory_order_relaxed ) & DIRTY_BIT )
+		{
+			frontId = middle.exchange( frontId, std::memory_order_acq_rel ) & ID_MASK;
+		}
+		return slots[frontId];
+	}
+
+private:
+	static const int ID_MASK = 0x3;
+	static const int DIRTY_BIT = 0x4;	//  set on the middle slot id when it holds an unread value
+
+	T slots[3];
+	int backId = 0;						//  writer only
+	int frontId = 1;					//  reader only
+	std::atomic<int> middle { 2 };
+};
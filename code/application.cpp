@@ -1,6 +1,7 @@
 //
 //  application.cpp
 //
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
@@ -8,6 +9,7 @@
 #include "Renderer/model.h"
 #include "Renderer/shader.h"
 #include "Renderer/Samplers.h"
+#include "Renderer/MemoryAllocator.h"
 
 #include "application.h"
 #include "Fileio.h"
@@ -16,9 +18,17 @@
 #include "Renderer/OffscreenRenderer.h"
 
 #include "Scene.h"
+#include "Math/Transforms.h"
+#include "Math/Frustum.h"
 
 Application* application = NULL;
 
+//  storage for the in-class constant, indexed at run time
+constexpr float Application::LOD_SCREEN_RADII[];
+
+//  built by tools/pack_shaders.py from data/shaders/spirv
+static const char* SHADER_ARCHIVE_FILE = "data/shaders/shaders.pak";
+
 #include <time.h>
 #include <windows.h>
 
@@ -85,16 +95,20 @@ void Application::Initialize()
 	scene->Initialize();
 	scene->Reset();
 
-	m_models.reserve( scene->bodies.size() );
 	for ( int i = 0; i < scene->bodies.size(); i++ )
 	{
 		CreateModelForBody( scene->bodies[i] );
 	}
 
+	//  all the meshes of the scene go to the gpu in a single submit
+	deviceContext.FlushUploads();
+	deviceContext.m_memoryAllocator->PrintStats();
+
 	m_mousePosition = Vec2( 0, 0 );
 
 	m_isPaused = false;
-	m_stepFrame = false;
+
+	m_physicsThread.Start( this, scene );
 }
 
 /*
@@ -226,14 +240,10 @@ bool Application::InitializeVulkan()
 	}
 
 	//
-	//	Uniform Buffer
+	//	Per frame uniforms and instances
 	//
-	m_uniformBuffer.Allocate( &deviceContext, NULL, sizeof( float ) * 16 * 4 * 128, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT );
-
-	//
-	//	Offscreen rendering
-	//
-	InitOffscreen( &deviceContext, deviceContext.m_swapChain.m_windowWidth, deviceContext.m_swapChain.m_windowHeight );
+	m_uniformRing.Create( &deviceContext, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT );
+	m_instanceRing.Create( &deviceContext, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT );
 
 	//
 	//	Full screen texture rendering
@@ -247,14 +257,6 @@ bool Application::InitializeVulkan()
 		}
 		m_modelFullScreen.MakeVBO( &deviceContext );
 
-		result = m_copyShader.Load( &deviceContext, "DebugImage2D" );
-		if ( !result )
-		{
-			printf( "ERROR: Failed to load copy shader\n" );
-			assert( 0 );
-			return false;
-		}
-
 		Descriptors::CreateParms_t descriptorParms;
 		memset( &descriptorParms, 0, sizeof( descriptorParms ) );
 		descriptorParms.numUniformsFragment = 1;
@@ -266,24 +268,37 @@ bool Application::InitializeVulkan()
 			assert( 0 );
 			return false;
 		}
+	}
 
-		Pipeline::CreateParms_t pipelineParms;
-		memset( &pipelineParms, 0, sizeof( pipelineParms ) );
-		pipelineParms.renderPass = deviceContext.m_swapChain.m_vkRenderPass;
-		pipelineParms.descriptors = &m_copyDescriptors;
-		pipelineParms.shader = &m_copyShader;
-		pipelineParms.width = deviceContext.m_swapChain.m_windowWidth;
-		pipelineParms.height = deviceContext.m_swapChain.m_windowHeight;
-		pipelineParms.cullMode = Pipeline::CULL_MODE_NONE;
-		pipelineParms.depthTest = false;
-		pipelineParms.depthWrite = false;
-		result = m_copyPipeline.Create( &deviceContext, pipelineParms );
-		if ( !result )
+	//
+	//	Offscreen rendering, the copy shader and pipeline are built alongside the offscreen ones
+	//
+	{
+		const int startTime = GetTimeMicroseconds();
+
+		// A single mapped file holds all the shaders, only needed until they are loaded
+		if ( !Shader::OpenArchive( SHADER_ARCHIVE_FILE ) )
 		{
-			printf( "ERROR: Failed to create copy pipeline\n" );
+			printf( "WARNING: No shader archive, loading the shaders from data/shaders/spirv\n" );
+		}
+
+		std::atomic<bool> isCopyPipelineCreated( false );
+		JobSystem::JobCounter counter( 0 );
+		m_renderJobs.Submit( [this, &isCopyPipelineCreated]
+			{
+				isCopyPipelineCreated = m_copyShader.Load( &deviceContext, "DebugImage2D" ) && CreateCopyPipeline();
+			}, &counter );
+
+		const bool isOffscreenCreated = InitOffscreen( &deviceContext, m_renderJobs, deviceContext.m_swapChain.m_windowWidth, deviceContext.m_swapChain.m_windowHeight );
+		m_renderJobs.Wait( counter );
+		Shader::CloseArchive();
+		if ( !isOffscreenCreated || !isCopyPipelineCreated )
+		{
+			printf( "ERROR: Failed to create pipelines\n" );
 			assert( 0 );
 			return false;
 		}
+		printf( "shaders and pipelines created in %.2f ms\n", ( GetTimeMicroseconds() - startTime ) * 0.001f );
 	}
 
 	return true;
@@ -296,6 +311,9 @@ Application::Cleanup
 */
 void Application::Cleanup()
 {
+	// The frames in flight may still use the resources
+	vkDeviceWaitIdle( deviceContext.m_vkDevice );
+
 	CleanupOffscreen( &deviceContext );
 
 	m_copyShader.Cleanup( &deviceContext );
@@ -304,6 +322,7 @@ void Application::Cleanup()
 	m_modelFullScreen.Cleanup( deviceContext );
 
 	// Delete the screen so that it can clean itself up
+	m_physicsThread.Stop();
 	delete scene;
 	scene = NULL;
 
@@ -314,9 +333,15 @@ void Application::Cleanup()
 		delete m_models[i];
 	}
 	m_models.clear();
+	m_meshes.clear();
+	m_bodyMeshes.clear();
+	m_bodyLods.clear();
+	m_bodyModels.clear();
+	m_bodyIsStatic.clear();
 
 	// Delete Uniform Buffer Memory
-	m_uniformBuffer.Cleanup( &deviceContext );
+	m_uniformRing.Cleanup( &deviceContext );
+	m_instanceRing.Cleanup( &deviceContext );
 
 	// Delete Samplers
 	Samplers::Cleanup( &deviceContext );
@@ -355,24 +380,13 @@ void Application::ResizeWindow( int windowWidth, int windowHeight )
 	deviceContext.ResizeWindow( windowWidth, windowHeight );
 
 	//
-	//	Full screen texture rendering
+	//	Full screen texture rendering, the viewport and scissor are dynamic state so
+	//	the pipeline outlives the swap chain as long as its render pass stays compatible
 	//
+	if ( deviceContext.m_swapChain.m_vkColorImageFormat != m_copyPipelineFormat )
 	{
-		bool result;
 		m_copyPipeline.Cleanup( &deviceContext );
-
-		Pipeline::CreateParms_t pipelineParms;
-		memset( &pipelineParms, 0, sizeof( pipelineParms ) );
-		pipelineParms.renderPass = deviceContext.m_swapChain.m_vkRenderPass;
-		pipelineParms.descriptors = &m_copyDescriptors;
-		pipelineParms.shader = &m_copyShader;
-		pipelineParms.width = windowWidth;
-		pipelineParms.height = windowHeight;
-		pipelineParms.cullMode = Pipeline::CULL_MODE_NONE;
-		pipelineParms.depthTest = false;
-		pipelineParms.depthWrite = false;
-		result = m_copyPipeline.Create( &deviceContext, pipelineParms );
-		if ( !result )
+		if ( !CreateCopyPipeline() )
 		{
 			printf( "Unable to build pipeline!\n" );
 			assert( 0 );
@@ -381,6 +395,33 @@ void Application::ResizeWindow( int windowWidth, int windowHeight )
 	}
 }
 
+/*
+====================================================
+Application::CreateCopyPipeline
+====================================================
+*/
+bool Application::CreateCopyPipeline()
+{
+	Pipeline::CreateParms_t pipelineParms;
+	memset( &pipelineParms, 0, sizeof( pipelineParms ) );
+	pipelineParms.renderPass = deviceContext.m_swapChain.m_vkRenderPass;
+	pipelineParms.descriptors = &m_copyDescriptors;
+	pipelineParms.shader = &m_copyShader;
+	pipelineParms.width = deviceContext.m_swapChain.m_windowWidth;
+	pipelineParms.height = deviceContext.m_swapChain.m_windowHeight;
+	pipelineParms.cullMode = Pipeline::CULL_MODE_NONE;
+	pipelineParms.depthTest = false;
+	pipelineParms.depthWrite = false;
+	if ( !m_copyPipeline.Create( &deviceContext, pipelineParms ) )
+	{
+		printf( "ERROR: Failed to create copy pipeline\n" );
+		return false;
+	}
+
+	m_copyPipelineFormat = deviceContext.m_swapChain.m_vkColorImageFormat;
+	return true;
+}
+
 /*
 ====================================================
 Application::OnMouseMoved
@@ -460,9 +501,13 @@ Application::Keyboard
 */
 void Application::Keyboard( int key, int scancode, int action, int modifiers )
 {
+	InputEvent event;
 	if ( GLFW_KEY_R == key && GLFW_RELEASE == action )
 	{
-		scene->Reset();
+		event.type = InputEventType::Reset;
+		m_physicsThread.PushInput( event );
+
+		m_isShadowCacheReset = true;
 	}
 	else if ( GLFW_KEY_T == key && GLFW_RELEASE == action )
 	{
@@ -470,11 +515,18 @@ void Application::Keyboard( int key, int scancode, int action, int modifiers )
 	}
 	else if ( GLFW_KEY_Y == key && ( GLFW_PRESS == action || GLFW_REPEAT == action ) )
 	{
-		m_stepFrame = m_isPaused && !m_stepFrame;
+		if ( m_isPaused )
+		{
+			event.type = InputEventType::Step;
+			m_physicsThread.PushInput( event );
+		}
 	}
 	else
 	{
-		scene->OnKeyInput( key, action );
+		event.type = InputEventType::Key;
+		event.key = key;
+		event.action = action;
+		m_physicsThread.PushInput( event );
 	}
 }
 
@@ -486,9 +538,6 @@ Application::MainLoop
 void Application::MainLoop()
 {
 	static int timeLastFrame = 0;
-	static int numSamples = 0;
-	static float avgTime = 0.0f;
-	static float maxTime = 0.0f;
 
 	while ( !glfwWindowShouldClose( glfwWindow ) )
 	{
@@ -506,67 +555,125 @@ void Application::MainLoop()
 		// Get User Input
 		glfwPollEvents();
 
-		// If the time is greater than 33ms (30fps)
-		// then force the time difference to smaller
-		// to prevent super large simulation steps.
-		if ( dt_us > 33000.0f )
-		{
-			dt_us = 33000.0f;
-		}
+		// The physics thread runs the scene, it only needs the view from here
+		m_physicsThread.SetCamera( camera );
 
-		bool runPhysics = true;
-		if ( m_isPaused )
+		// Draw the Scene
+		DrawFrame();
+	}
+}
+
+/*
+====================================================
+IsSameMesh
+
+Whether both shapes build the same model, so it can be shared
+====================================================
+*/
+static bool IsSameMesh( const Shape* a, const Shape* b )
+{
+	if ( a == b ) return true;
+	if ( a->GetType() != b->GetType() ) return false;
+
+	switch ( a->GetType() )
+	{
+		case Shape::ShapeType::SHAPE_SPHERE:
+			return ( (const ShapeSphere*) a )->radius == ( (const ShapeSphere*) b )->radius;
+		case Shape::ShapeType::SHAPE_BOX:
 		{
-			dt_us = 0.0f;
-			runPhysics = false;
-			if ( m_stepFrame )
-			{
-				dt_us = 16667.0f;
-				m_stepFrame = false;
-				runPhysics = true;
-			}
-			numSamples = 0;
-			maxTime = 0.0f;
+			const Bounds& boundsA = ( (const ShapeBox*) a )->bounds;
+			const Bounds& boundsB = ( (const ShapeBox*) b )->bounds;
+			return boundsA.mins == boundsB.mins && boundsA.maxs == boundsB.maxs;
 		}
-		float dt_sec = dt_us * 0.001f * 0.001f;
+		case Shape::ShapeType::SHAPE_CONVEX:
+			return ( (const ShapeConvex*) a )->points == ( (const ShapeConvex*) b )->points;
+		default:
+			return false;
+	}
+}
 
-		// Run Update
-		scene->Update( dt_sec );
-		if ( runPhysics )
+void Application::CreateModelForBody( const Body& body )
+{
+	// Bodies with the same mesh share its models, and are drawn as instances of them
+	int meshId = -1;
+	for ( int i = 0; i < m_meshes.size(); i++ )
+	{
+		if ( IsSameMesh( m_meshes[i].shape, body.shape ) )
 		{
-			//printf( "dt_ms: %.1f FPS: %.0f\n", dt_us * 0.001f, 1.0f / dt_sec );
-
-			int startTime = GetTimeMicroseconds();
-			for ( int i = 0; i < 2; i++ )
-			{
-				scene->UpdatePhysics( dt_sec * 0.5f );
-			}
-			int endTime = GetTimeMicroseconds();
+			meshId = i;
+			break;
+		}
+	}
 
-			dt_us = (float) endTime - (float) startTime;
-			if ( dt_us > maxTime )
-			{
-				maxTime = dt_us;
-			}
+	if ( meshId < 0 )
+	{
+		Mesh mesh;
+		mesh.shape = body.shape;
+		mesh.firstModel = (int) m_models.size();
+		mesh.numLods = Model::GetNumLods( body.shape );
 
-			avgTime = ( avgTime * float( numSamples ) + dt_us ) / float( numSamples + 1 );
-			numSamples++;
+		// Sphere around the local bounds, it holds whatever the orientation
+		const Bounds bounds = body.shape->GetBounds();
+		mesh.boundsCenter = ( bounds.mins + bounds.maxs ) * 0.5f;
+		mesh.boundsRadius = ( bounds.maxs - bounds.mins ).GetMagnitude() * 0.5f;
 
-			//printf( "frame dt_ms: %.2f %.2f %.2f\n", avgTime * 0.001f, maxTime * 0.001f, dt_us * 0.001f );
+		for ( int lod = 0; lod < mesh.numLods; lod++ )
+		{
+			Model* model = new Model();
+			model->BuildFromShape( body.shape, lod );
+			model->MakeVBO( &deviceContext );
+			m_models.push_back( model );
 		}
 
-		// Draw the Scene
-		DrawFrame();
+		meshId = (int) m_meshes.size();
+		m_meshes.push_back( mesh );
 	}
+
+	m_bodyMeshes.push_back( meshId );
+	m_bodyLods.push_back( 0 );
+	m_bodyIsStatic.push_back( body.IsStatic() );
+	m_bodyModels.push_back( m_meshes[meshId].firstModel );
 }
 
-void Application::CreateModelForBody( const Body& body )
+/*
+====================================================
+Application::UpdateShadowCache
+
+Picks the shadow casters of the static shadow map. A body
+leaves it for the dynamic shadow pass as soon as it moves,
+the map is then rebuilt without it.
+====================================================
+*/
+void Application::UpdateShadowCache( const TransformSnapshot& snapshot )
 {
-	Model* model = new Model();
-	model->BuildFromShape( body.shape );
-	model->MakeVBO( &deviceContext );
+	const int numBodies = (int) snapshot.current.size();
+	if ( m_isShadowCacheReset || m_shadowCachedTransforms.size() != numBodies )
+	{
+		m_isShadowCacheReset = false;
 
-	m_models.push_back( model );
+		m_bodyIsShadowCached = m_bodyIsStatic;
+		m_bodyIsShadowCached.resize( numBodies, 0 );
+		m_shadowCachedTransforms = snapshot.current;
+		InvalidateStaticShadow();
+		return;
+	}
+
+	for ( int i = 0; i < numBodies; i++ )
+	{
+		if ( !m_bodyIsShadowCached[i] ) continue;
+
+		// Static bodies are never integrated, any change means they were moved
+		const BodyTransform& cached = m_shadowCachedTransforms[i];
+		const BodyTransform& current = snapshot.current[i];
+		if ( cached.position == current.position
+		  && cached.orientation.w == current.orientation.w
+		  && cached.orientation.x == current.orientation.x
+		  && cached.orientation.y == current.orientation.y
+		  && cached.orientation.z == current.orientation.z ) continue;
+
+		m_bodyIsShadowCached[i] = 0;
+		InvalidateStaticShadow();
+	}
 }
 
 /*
@@ -574,13 +681,19 @@ void Application::CreateModelForBody( const Body& body )
 Application::UpdateUniforms
 ====================================================
 */
-void Application::UpdateUniforms()
+bool Application::UpdateUniforms()
 {
-	m_renderModels.clear();
+	for ( int pass = 0; pass < NUM_DRAW_PASSES; pass++ )
+	{
+		m_renderModels[pass].clear();
+		m_renderBatches[pass].clear();
+	}
 
-	uint32_t uboByteOffset = 0;
-	uint32_t cameraByteOFfset = 0;
-	uint32_t shadowByteOffset = 0;
+	// Newest state published by the physics thread, the camera follows its focus
+	const TransformSnapshot& snapshot = m_physicsThread.AcquireSnapshot();
+	camera.FocusPoint = snapshot.focusPoint;
+
+	UpdateShadowCache( snapshot );
 
 	struct camera_t
 	{
@@ -590,12 +703,17 @@ void Application::UpdateUniforms()
 		Mat4 pad1;
 	};
 	camera_t camera_matrices;
+	Frustum frustums[NUM_DRAW_PASSES];
+	Vec3 cameraPosition;
+	float screenScale = 1.0f;	// screen radius in pixels of a unit sphere at a distance of 1
 
 	//
 	//	Update the uniform buffers
 	//
 	{
-		unsigned char* mappedData = (unsigned char*) m_uniformBuffer.MapBuffer( &deviceContext );
+		// The allocations of the last frame that used this index are free again
+		m_uniformRing.BeginFrame( deviceContext.m_frameIndex );
+		m_instanceRing.BeginFrame( deviceContext.m_frameIndex );
 
 		//
 		// Update the uniform buffer with the camera information
@@ -614,18 +732,23 @@ void Application::UpdateUniforms()
 			const float fovy = 45.0f;
 			const float aspect = (float) windowHeight / (float) windowWidth;
 			camera_matrices.matProj.PerspectiveVulkan( fovy, aspect, zNear, zFar );
-			camera_matrices.matProj = camera_matrices.matProj.Transpose();
-
 			camera_matrices.matView.LookAt( camPos, camLookAt, camUp );
-			camera_matrices.matView = camera_matrices.matView.Transpose();
+			frustums[DRAW_PASS_MAIN].SetFromMatrix( camera_matrices.matProj * camera_matrices.matView );
 
-			// Update the uniform buffer for the camera matrices
-			memcpy( mappedData + uboByteOffset, &camera_matrices, sizeof( camera_matrices ) );
+			const float pi = acosf( -1.0f );
+			cameraPosition = camPos;
+			screenScale = 0.5f * (float) windowHeight / tanf( fovy * 0.5f * pi / 180.0f );
 
-			cameraByteOFfset = uboByteOffset;
+			camera_matrices.matProj = camera_matrices.matProj.Transpose();
+			camera_matrices.matView = camera_matrices.matView.Transpose();
 
-			// update offset into the buffer
-			uboByteOffset += deviceContext.GetAligendUniformByteOffset( sizeof( camera_matrices ) );
+			// Update the uniform buffer for the camera matrices
+			m_cameraUniforms = m_uniformRing.Allocate( &deviceContext, sizeof( camera_matrices ) );
+			if ( NULL == m_cameraUniforms.data )
+			{
+				return false;
+			}
+			memcpy( m_cameraUniforms.data, &camera_matrices, sizeof( camera_matrices ) );
 		}
 
 		//
@@ -651,50 +774,238 @@ void Application::UpdateUniforms()
 			const float zNear = 25.0f;
 			const float zFar = 175.0f;
 			camera_matrices.matProj.OrthoVulkan( xmin, xmax, ymin, ymax, zNear, zFar );
-			camera_matrices.matProj = camera_matrices.matProj.Transpose();
-
 			camera_matrices.matView.LookAt( camPos, camLookAt, camUp );
+			frustums[DRAW_PASS_SHADOW].SetFromMatrix( camera_matrices.matProj * camera_matrices.matView );
+
+			camera_matrices.matProj = camera_matrices.matProj.Transpose();
 			camera_matrices.matView = camera_matrices.matView.Transpose();
 
 			// Update the uniform buffer for the camera matrices
-			memcpy( mappedData + uboByteOffset, &camera_matrices, sizeof( camera_matrices ) );
+			m_shadowCameraUniforms = m_uniformRing.Allocate( &deviceContext, sizeof( camera_matrices ) );
+			if ( NULL == m_shadowCameraUniforms.data )
+			{
+				return false;
+			}
+			memcpy( m_shadowCameraUniforms.data, &camera_matrices, sizeof( camera_matrices ) );
+		}
 
-			shadowByteOffset = uboByteOffset;
+		//
+		//	Update the uniform buffer with the body positions/orientations,
+		//	interpolated between the last two physics steps
+		//
+		const float stepElapsed = (float) ( GetTimeMicroseconds() - snapshot.stepTime ) * 0.001f * 0.001f;
+		const float alpha = m_isPaused ? 1.0f : std::min( stepElapsed / PhysicsThread::PHYSICS_DT, 1.0f );
+		const int numBodies = (int) snapshot.current.size();
+		m_bodyPositions.resize( numBodies );
+		m_bodyOrientations.resize( numBodies );
+		m_bodyMatrices.resize( numBodies );
+		for ( int i = 0; i < numBodies; i++ )
+		{
+			const BodyTransform& previous = snapshot.previous[i];
+			const BodyTransform& current = snapshot.current[i];
 
-			// update offset into the buffer
-			uboByteOffset += deviceContext.GetAligendUniformByteOffset( sizeof( camera_matrices ) );
+			m_bodyPositions[i] = previous.position + ( current.position - previous.position ) * alpha;
+			m_bodyOrientations[i] = Quat::Lerp( previous.orientation, current.orientation, alpha );
 		}
 
+		// All the model matrices at once, already transposed for the shaders
+		BuildModelMatrices( m_bodyPositions.data(), m_bodyOrientations.data(), m_bodyMatrices.data(), numBodies );
+
 		//
-		//	Update the uniform buffer with the body positions/orientations
+		//	Cull the bounding spheres of the bodies against the frustum of each pass
 		//
-		for ( int i = 0; i < scene->bodies.size(); i++ )
+		m_bodyBoundsCenters.resize( numBodies );
+		m_bodyBoundsRadii.resize( numBodies );
+		for ( int i = 0; i < numBodies; i++ )
+		{
+			const Mesh& mesh = m_meshes[m_bodyMeshes[i]];
+			m_bodyBoundsCenters[i] = mesh.boundsCenter;
+			m_bodyBoundsRadii[i] = mesh.boundsRadius;
+		}
+		RotatePoints( m_bodyOrientations.data(), m_bodyBoundsCenters.data(), m_bodyBoundsCenters.data(), numBodies );
+		for ( int i = 0; i < numBodies; i++ )
 		{
-			Body& body = scene->bodies[i];
+			m_bodyBoundsCenters[i] += m_bodyPositions[i];
+		}
 
-			Vec3 fwd = body.orientation.RotatePoint( Vec3( 1, 0, 0 ) );
-			Vec3 up = body.orientation.RotatePoint( Vec3( 0, 0, 1 ) );
+		//
+		//	Pick the lod of each body from its radius on screen, both passes use it
+		//
+		for ( int i = 0; i < numBodies; i++ )
+		{
+			const Mesh& mesh = m_meshes[m_bodyMeshes[i]];
 
-			Mat4 matOrient;
-			matOrient.Orient( body.position, fwd, up );
-			matOrient = matOrient.Transpose();
+			const float distance = std::max( ( m_bodyBoundsCenters[i] - cameraPosition ).GetMagnitude(), 0.001f );
+			const float screenRadius = m_bodyBoundsRadii[i] * screenScale / distance;
 
-			// Update the uniform buffer with the orientation of this body
-			memcpy( mappedData + uboByteOffset, matOrient.ToPtr(), sizeof( matOrient ) );
+			// Only move past a threshold by more than the hysteresis, so a body on the edge doesn't pop back and forth
+			int lod = std::min( m_bodyLods[i], mesh.numLods - 1 );
+			while ( lod > 0 && screenRadius > LOD_SCREEN_RADII[lod - 1] * ( 1.0f + LOD_HYSTERESIS ) )
+			{
+				lod--;
+			}
+			while ( lod < mesh.numLods - 1 && screenRadius < LOD_SCREEN_RADII[lod] * ( 1.0f - LOD_HYSTERESIS ) )
+			{
+				lod++;
+			}
+
+			m_bodyLods[i] = lod;
+			m_bodyModels[i] = mesh.firstModel + lod;
+		}
+
+		for ( int pass = 0; pass < NUM_DRAW_PASSES; pass++ )
+		{
+			m_bodyVisibility[pass].resize( numBodies );
+		}
+		std::vector<unsigned char>& staticShadowVisibility = m_bodyVisibility[DRAW_PASS_STATIC_SHADOW];
+		std::vector<unsigned char>& shadowVisibility = m_bodyVisibility[DRAW_PASS_SHADOW];
+		frustums[DRAW_PASS_SHADOW].CullSpheres( m_bodyBoundsCenters.data(), m_bodyBoundsRadii.data(), shadowVisibility.data(), numBodies );
+		frustums[DRAW_PASS_MAIN].CullSpheres( m_bodyBoundsCenters.data(), m_bodyBoundsRadii.data(), m_bodyVisibility[DRAW_PASS_MAIN].data(), numBodies );
+
+		// The cached shadow casters leave the shadow pass, they are only drawn when the cache is rebuilt
+		const bool isStaticShadowDirty = IsStaticShadowDirty();
+		int numCandidates[NUM_DRAW_PASSES] = {};
+		numCandidates[DRAW_PASS_MAIN] = numBodies;
+		for ( int i = 0; i < numBodies; i++ )
+		{
+			if ( m_bodyIsShadowCached[i] )
+			{
+				staticShadowVisibility[i] = isStaticShadowDirty && shadowVisibility[i];
+				shadowVisibility[i] = 0;
+				numCandidates[DRAW_PASS_STATIC_SHADOW] += isStaticShadowDirty;
+			}
+			else
+			{
+				staticShadowVisibility[i] = 0;
+				numCandidates[DRAW_PASS_SHADOW]++;
+			}
+		}
+
+		int numVisible = 0;
+		for ( int pass = 0; pass < NUM_DRAW_PASSES; pass++ )
+		{
+			DrawStats& drawStats = m_drawStats[pass];
+			drawStats.numDrawn = 0;
+			drawStats.numTriangles = 0;
+			for ( int i = 0; i < numBodies; i++ )
+			{
+				if ( !m_bodyVisibility[pass][i] ) continue;
+				drawStats.numDrawn++;
+				drawStats.numTriangles += (int) m_models[GetPassModel( pass, i )]->m_indices.size() / 3;
+			}
+			drawStats.numCulled = numCandidates[pass] - drawStats.numDrawn;
+			numVisible += drawStats.numDrawn;
+		}
 
-			RenderModel renderModel;
-			renderModel.model = m_models[i];
-			renderModel.uboByteOffset = uboByteOffset;
-			renderModel.uboByteSize = sizeof( matOrient );
-			renderModel.pos = body.position;
-			renderModel.orient = body.orientation;
-			m_renderModels.push_back( renderModel );
+		if ( IsInstancingEnabled() )
+		{
+			// Group the visible bodies of each pass by model, each group is a single instanced draw.
+			// The instances of all the passes share the same allocation, one pass after the other.
+			m_instances = m_instanceRing.Allocate( &deviceContext, sizeof( instance_t ) * numVisible );
+			if ( NULL == m_instances.data )
+			{
+				return false;
+			}
+			instance_t* instances = (instance_t*) m_instances.data;
 
-			uboByteOffset += deviceContext.GetAligendUniformByteOffset( sizeof( matOrient ) );
+			uint32_t firstInstance = 0;
+			for ( int pass = 0; pass < NUM_DRAW_PASSES; pass++ )
+			{
+				std::vector<RenderBatch>& renderBatches = m_renderBatches[pass];
+				const std::vector<unsigned char>& visibility = m_bodyVisibility[pass];
+
+				renderBatches.resize( m_models.size() );
+				for ( int i = 0; i < m_models.size(); i++ )
+				{
+					renderBatches[i].model = m_models[i];
+					renderBatches[i].firstInstance = 0;
+					renderBatches[i].numInstances = 0;
+				}
+				for ( int i = 0; i < numBodies; i++ )
+				{
+					if ( !visibility[i] ) continue;
+					renderBatches[GetPassModel( pass, i )].numInstances++;
+				}
+
+				for ( int i = 0; i < renderBatches.size(); i++ )
+				{
+					renderBatches[i].firstInstance = firstInstance;
+					firstInstance += renderBatches[i].numInstances;
+					renderBatches[i].numInstances = 0;
+				}
+
+				for ( int i = 0; i < numBodies; i++ )
+				{
+					if ( !visibility[i] ) continue;
+
+					RenderBatch& renderBatch = renderBatches[GetPassModel( pass, i )];
+					memcpy( instances[renderBatch.firstInstance + renderBatch.numInstances].matModel, m_bodyMatrices[i].ToPtr(), sizeof( instance_t ) );
+					renderBatch.numInstances++;
+				}
+
+				renderBatches.erase(
+					std::remove_if( renderBatches.begin(), renderBatches.end(), []( const RenderBatch& renderBatch ) { return 0 == renderBatch.numInstances; } ),
+					renderBatches.end()
+				);
+			}
 		}
+		else
+		{
+			for ( int i = 0; i < numBodies; i++ )
+			{
+				bool isVisible = false;
+				for ( int pass = 0; pass < NUM_DRAW_PASSES; pass++ )
+				{
+					isVisible = isVisible || m_bodyVisibility[pass][i];
+				}
+				if ( !isVisible ) continue;
+
+				const Mat4& matOrient = m_bodyMatrices[i];
+
+				// Update the uniform buffer with the orientation of this body
+				const RingAllocation_t uniforms = m_uniformRing.Allocate( &deviceContext, sizeof( matOrient ) );
+				if ( NULL == uniforms.data )
+				{
+					return false;
+				}
+				memcpy( uniforms.data, matOrient.ToPtr(), sizeof( matOrient ) );
+
+				RenderModel renderModel;
+				renderModel.uniformBuffer = uniforms.buffer;
+				renderModel.uboByteOffset = uniforms.offset;
+				renderModel.uboByteSize = uniforms.size;
+				renderModel.pos = m_bodyPositions[i];
+				renderModel.orient = m_bodyOrientations[i];
+
+				// All the passes read the same uniforms
+				for ( int pass = 0; pass < NUM_DRAW_PASSES; pass++ )
+				{
+					if ( !m_bodyVisibility[pass][i] ) continue;
+					renderModel.model = m_models[GetPassModel( pass, i )];
+					m_renderModels[pass].push_back( renderModel );
+				}
+			}
+		}
+	}
 
-		m_uniformBuffer.UnmapBuffer( &deviceContext );
+	//
+	//	Report the culling once a second
+	//
+	const int time = GetTimeMicroseconds();
+	if ( time - m_timeLastDrawStats > 1000 * 1000 )
+	{
+		m_timeLastDrawStats = time;
+
+		const DrawStats& staticShadowStats = m_drawStats[DRAW_PASS_STATIC_SHADOW];
+		const DrawStats& shadowStats = m_drawStats[DRAW_PASS_SHADOW];
+		const DrawStats& mainStats = m_drawStats[DRAW_PASS_MAIN];
+		printf( "draw static shadow: %i drawn %i culled %i tris | shadow: %i drawn %i culled %i tris | main: %i drawn %i culled %i tris\n",
+			staticShadowStats.numDrawn, staticShadowStats.numCulled, staticShadowStats.numTriangles,
+			shadowStats.numDrawn, shadowStats.numCulled, shadowStats.numTriangles,
+			mainStats.numDrawn, mainStats.numCulled, mainStats.numTriangles );
 	}
+
+	return true;
 }
 
 /*
@@ -704,15 +1015,26 @@ Application::DrawFrame
 */
 void Application::DrawFrame()
 {
-	UpdateUniforms();
-
 	//
-	//	Begin the render frame
+	//	Begin the render frame, this waits for the gpu to be done with the
+	//	previous use of the frame index before its uniforms get overwritten
 	//
-	const uint32_t imageIndex = deviceContext.BeginFrame();
+	const uint32_t frameIndex = deviceContext.BeginFrame();
 
-	// Draw everything in an offscreen buffer
-	DrawOffscreen( &deviceContext, imageIndex, &m_uniformBuffer, m_renderModels.data(), (int) m_renderModels.size() );
+	// Draw everything in an offscreen buffer.
+	// Without room for the uniforms the draws are skipped, the last offscreen image is shown again.
+	if ( UpdateUniforms() )
+	{
+		DrawList_t drawLists[NUM_DRAW_PASSES];
+		for ( int pass = 0; pass < NUM_DRAW_PASSES; pass++ )
+		{
+			drawLists[pass].renderModels = m_renderModels[pass].data();
+			drawLists[pass].numModels = (int) m_renderModels[pass].size();
+			drawLists[pass].renderBatches = m_renderBatches[pass].data();
+			drawLists[pass].numBatches = (int) m_renderBatches[pass].size();
+		}
+		DrawOffscreen( &deviceContext, m_renderJobs, frameIndex, m_cameraUniforms, m_shadowCameraUniforms, m_instances, drawLists );
+	}
 
 	//
 	//	Draw the offscreen framebuffer to the swap chain frame buffer
@@ -720,12 +1042,13 @@ void Application::DrawFrame()
 	deviceContext.BeginRenderPass();
 	{
 		extern FrameBuffer g_offscreenFrameBuffer;
-		VkCommandBuffer cmdBuffer = deviceContext.m_vkCommandBuffers[imageIndex];
+		VkCommandBuffer cmdBuffer = deviceContext.m_vkCommandBuffers[frameIndex];
 
 		// Binding the pipeline is effectively the "use shader" we had back in our opengl apps
 		m_copyPipeline.BindPipeline( cmdBuffer );
 
 		// Descriptor is how we bind our buffers and images
+		m_copyDescriptors.BeginFrame( &deviceContext );
 		Descriptor descriptor = m_copyPipeline.GetFreeDescriptor();
 		descriptor.BindImage( VK_IMAGE_LAYOUT_GENERAL, g_offscreenFrameBuffer.m_imageColor.m_vkImageView, Samplers::m_samplerStandard, 0 );
 		descriptor.BindDescriptor( &deviceContext, cmdBuffer, &m_copyPipeline );
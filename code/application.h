@@ -18,7 +18,13 @@
 #include "Renderer/model.h"
 #include "Renderer/shader.h"
 #include "Renderer/FrameBuffer.h"
+#include "Renderer/RingBuffer.h"
+#include "Renderer/OffscreenRenderer.h"
 #include "Camera.h"
+#include "PhysicsThread.h"
+#include "JobSystem.h"
+
+#include <atomic>
 
 /*
 ====================================================
@@ -28,7 +34,7 @@ Application
 class Application
 {
 public:
-	Application() : m_isPaused( true ), m_stepFrame( false ) {}
+	Application() : m_isPaused( true ) {}
 	~Application();
 
 	void Initialize();
@@ -45,9 +51,11 @@ private:
 	void InitializeGLFW();
 	bool InitializeVulkan();
 	void Cleanup();
-	void UpdateUniforms();
+	bool UpdateUniforms();
+	void UpdateShadowCache( const TransformSnapshot& snapshot );
 	void DrawFrame();
 	void ResizeWindow( int windowWidth, int windowHeight );
+	bool CreateCopyPipeline();
 	void MouseMoved( float x, float y );
 	void MouseScrolled( float z );
 	void Keyboard( int key, int scancode, int action, int modifiers );
@@ -64,17 +72,39 @@ private:
 	GLFWwindow* glfwWindow;
 
 	DeviceContext deviceContext;
+	JobSystem m_renderJobs;		// records the draw lists into secondary command buffers
 
 	//
-	//	Uniform Buffer
+	//	Uniforms and per instance model matrices, rewritten every frame
 	//
-	Buffer m_uniformBuffer;
+	RingBuffer m_uniformRing;
+	RingBuffer m_instanceRing;
+	RingAllocation_t m_cameraUniforms;
+	RingAllocation_t m_shadowCameraUniforms;
+	RingAllocation_t m_instances;
 
 	//
 	//	Model
 	//
 	Model m_modelFullScreen;
-	std::vector< Model* > m_models;	// models for the bodies
+	struct Mesh
+	{
+		const Shape* shape;		// shape the models were built from
+		int firstModel;			// id of lod 0 in m_models, the other lods follow
+		int numLods;
+		Vec3 boundsCenter;		// bounding sphere, in model space
+		float boundsRadius;
+	};
+
+	std::vector< Model* > m_models;			// one model per lod of each distinct mesh
+	std::vector< Mesh > m_meshes;
+	std::vector< int > m_bodyMeshes;			// mesh id of each body
+	std::vector< int > m_bodyLods;				// lod of each body, kept for the hysteresis
+	std::vector< int > m_bodyModels;			// model id each body is drawn with this frame
+
+	//  lod l is kept while the screen radius of the body, in pixels, is over LOD_SCREEN_RADII[l]
+	static constexpr float LOD_SCREEN_RADII[Model::MAX_LODS - 1] = { 96.0f, 32.0f, 12.0f };
+	static constexpr float LOD_HYSTERESIS = 0.15f;	//  margin around each threshold before switching
 
 	//
 	//	Pipeline for copying the offscreen framebuffer to the swapchain
@@ -82,13 +112,50 @@ private:
 	Shader		m_copyShader;
 	Descriptors	m_copyDescriptors;
 	Pipeline	m_copyPipeline;
+	VkFormat	m_copyPipelineFormat = VK_FORMAT_UNDEFINED;	// format of the swap chain it was built for
 
 	// User input
 	Vec2 m_mousePosition;
-	bool m_isPaused;
-	bool m_stepFrame;
+	std::atomic<bool> m_isPaused;	// read by the physics thread
+
+	//
+	//	Draw lists of each drawPass_t, only the bodies in the frustum of the pass
+	//
+	struct DrawStats
+	{
+		int numDrawn = 0;
+		int numCulled = 0;
+		int numTriangles = 0;
+	};
+
+	std::vector<RenderModel> m_renderModels[NUM_DRAW_PASSES];
+	std::vector<RenderBatch> m_renderBatches[NUM_DRAW_PASSES];
+	std::vector<unsigned char> m_bodyVisibility[NUM_DRAW_PASSES];
+	DrawStats m_drawStats[NUM_DRAW_PASSES];
+	int m_timeLastDrawStats = 0;
+
+	//  the static shadow cache is only built once in a while, with the finest lods
+	int GetPassModel( int pass, int body ) const { return DRAW_PASS_STATIC_SHADOW == pass ? m_meshes[m_bodyMeshes[body]].firstModel : m_bodyModels[body]; }
+
+	//
+	//	Static shadow cache, the bodies static when created are in it until they move
+	//
+	std::vector<unsigned char> m_bodyIsStatic;
+	std::vector<unsigned char> m_bodyIsShadowCached;
+	std::vector<BodyTransform> m_shadowCachedTransforms;	// transforms of the bodies when they were cached
+	bool m_isShadowCacheReset = true;
+
+	// Interpolated transforms of the bodies, kept across frames to avoid reallocating
+	std::vector<Vec3> m_bodyPositions;
+	std::vector<Quat> m_bodyOrientations;
+	std::vector<Mat4> m_bodyMatrices;
+	std::vector<Vec3> m_bodyBoundsCenters;	// world space bounding spheres
+	std::vector<float> m_bodyBoundsRadii;
 
-	std::vector<RenderModel> m_renderModels;
+	//
+	//	Physics, the scene is only touched by this thread once started
+	//
+	PhysicsThread m_physicsThread;
 
 	static const int WINDOW_WIDTH = 1200;
 	static const int WINDOW_HEIGHT = 720;
@@ -96,4 +163,6 @@ private:
 	static const bool m_enableLayers = true;
 };
 
-extern Application* application;
\ No newline at end of file
+extern Application* application;
+
+int GetTimeMicroseconds();
\ No newline at end of file
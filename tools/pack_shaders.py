@@ -0,0 +1,62 @@
+#
+#  pack_shaders.py
+#
+#  Packs every data/shaders/spirv/<shader>.<stage>.spirv into data/shaders/shaders.pak,
+#  the archive read by ShaderArchive. Run it again whenever a shader is recompiled.
+#
+#  Layout, little endian:
+#    header    magic "SPAK", version, number of entries, reserved        4 x uint32
+#    entries   name (48 bytes, zero padded), stage, offset, size, reserved
+#    code      the SPIR-V of each entry, 4 bytes aligned
+#
+import os
+import struct
+import sys
+
+MAGIC = 0x4b415053
+VERSION = 1
+MAX_NAME = 48
+
+# Same order as Shader::ShaderStage_t
+STAGE_EXTENSIONS = [ "vert", "tess", "tval", "geom", "frag", "comp", "rgen", "ahit", "chit", "miss", "rint", "call", "task", "mesh" ]
+
+HEADER_FORMAT = "<4I"
+ENTRY_FORMAT = "<%ds4I" % MAX_NAME
+
+
+def main():
+	root = os.path.normpath( os.path.join( os.path.dirname( os.path.abspath( __file__ ) ), ".." ) )
+	spirv_dir = os.path.join( root, "data", "shaders", "spirv" )
+	archive_path = os.path.join( root, "data", "shaders", "shaders.pak" )
+
+	stages = []
+	for file_name in sorted( os.listdir( spirv_dir ) ):
+		parts = file_name.split( "." )
+		if len( parts ) != 3 or parts[ 2 ] != "spirv" or parts[ 1 ] not in STAGE_EXTENSIONS:
+			continue
+		if len( parts[ 0 ] ) >= MAX_NAME:
+			print( "ERROR: shader name too long %s" % file_name )
+			return 1
+
+		with open( os.path.join( spirv_dir, file_name ), "rb" ) as f:
+			code = f.read()
+		stages.append( ( parts[ 0 ], STAGE_EXTENSIONS.index( parts[ 1 ] ), code ) )
+
+	offset = struct.calcsize( HEADER_FORMAT ) + struct.calcsize( ENTRY_FORMAT ) * len( stages )
+	entries = b""
+	codes = b""
+	for name, stage, code in stages:
+		entries += struct.pack( ENTRY_FORMAT, name.encode( "ascii" ), stage, offset + len( codes ), len( code ), 0 )
+		codes += code + b"\0" * ( -len( code ) % 4 )
+
+	with open( archive_path, "wb" ) as f:
+		f.write( struct.pack( HEADER_FORMAT, MAGIC, VERSION, len( stages ), 0 ) )
+		f.write( entries )
+		f.write( codes )
+
+	print( "Packed %d shader stages into %s" % ( len( stages ), archive_path ) )
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit( main() )